@@ -8,7 +8,7 @@ BASE_DIR=$(dirname "$0")
 SUBJECTS_DIR="$BASE_DIR/project/erepair-subjects"
 
 # Projects with Makefile
-MAKE_PROJECTS=("cjson" "csv" "ini" "mjs" "sexp-parser" "tiny" "tri")
+MAKE_PROJECTS=("cjson" "csv" "ini" "jpeg" "mjs" "sexp-parser" "tiny" "tri")
 
 for proj in "${MAKE_PROJECTS[@]}"; do
     echo "Cleaning and building $proj..."
@@ -0,0 +1,291 @@
+//-------------------------------------
+// edit_distance.cpp
+//
+// Fills the distance_original_broken / distance_broken_repaired /
+// distance_original_repaired columns of a benchmark results table
+// (schema of bm_single.py, bm_multiple.py, bm_triple.py) in one pass.
+//
+// Distances are Levenshtein distances over Unicode code points, the same
+// numbers levenshtein_distance() in the bm scripts returns, computed with
+// Myers' bit-vector algorithm in Hyyrö's blocked form (64 pattern rows per
+// machine word), so a column costs ceil(m / 64) word operations instead of m
+// cells.  Rows are spread over worker threads; all updates are written in a
+// single transaction.
+//
+// Rows whose repaired distances are -1 (no repair output) keep -1.
+//
+// Build:  g++ -std=c++17 -O2 -pthread -o edit_distance edit_distance.cpp -lsqlite3
+// Usage:  ./edit_distance [-j threads] [-t table] [--check] <db> [db ...]
+//-------------------------------------
+#include <sqlite3.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+typedef std::vector<uint32_t> CodePoints;
+
+//-------------------------------------
+// 1. UTF-8 -> code points (bytes that do not decode are taken as is)
+//-------------------------------------
+static CodePoints decodeUtf8(const unsigned char* s, size_t n) {
+    CodePoints out;
+    out.reserve(n);
+    size_t i = 0;
+    while (i < n) {
+        uint32_t c = s[i];
+        int len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        bool ok = len > 0 && i + len <= n;
+        for (int k = 1; ok && k < len; k++) ok = (s[i + k] & 0xC0) == 0x80;
+        if (!ok || len == 1) {
+            out.push_back(c);
+            i++;
+            continue;
+        }
+        c &= 0xFF >> (len + 1);
+        for (int k = 1; k < len; k++) c = (c << 6) | (s[i + k] & 0x3F);
+        out.push_back(c);
+        i += len;
+    }
+    return out;
+}
+
+//-------------------------------------
+// 2. Blocked Myers bit-vector Levenshtein distance
+//-------------------------------------
+static long myers(const uint32_t* pattern, size_t m, const uint32_t* text, size_t n) {
+    if (m == 0) return static_cast<long>(n);
+    const size_t blocks = (m + 63) / 64;
+
+    // Peq[slot * blocks + block]: rows of the pattern equal to that character
+    std::vector<uint64_t> peq;
+    int ascii[128];
+    std::fill(ascii, ascii + 128, -1);
+    std::unordered_map<uint32_t, int> other;
+    auto slotOf = [&](uint32_t c) -> int {
+        if (c < 128) return ascii[c];
+        auto it = other.find(c);
+        return it == other.end() ? -1 : it->second;
+    };
+    for (size_t i = 0; i < m; i++) {
+        uint32_t c = pattern[i];
+        int slot = slotOf(c);
+        if (slot < 0) {
+            slot = static_cast<int>(peq.size() / blocks);
+            peq.resize(peq.size() + blocks, 0);
+            if (c < 128) ascii[c] = slot; else other[c] = slot;
+        }
+        peq[slot * blocks + i / 64] |= 1ULL << (i % 64);
+    }
+
+    std::vector<uint64_t> pv(blocks, ~0ULL), mv(blocks, 0);
+    const uint64_t last = 1ULL << ((m - 1) % 64);
+    long score = static_cast<long>(m);
+
+    for (size_t j = 0; j < n; j++) {
+        int slot = slotOf(text[j]);
+        const uint64_t* eqs = slot < 0 ? nullptr : &peq[slot * blocks];
+        int hin = 1;                                 // top row: D[0][j] = j
+        for (size_t k = 0; k < blocks; k++) {
+            uint64_t eq = eqs ? eqs[k] : 0;
+            uint64_t pvk = pv[k], mvk = mv[k];
+            uint64_t xv = eq | mvk;
+            if (hin < 0) eq |= 1;
+            uint64_t xh = (((eq & pvk) + pvk) ^ pvk) | eq;
+            uint64_t ph = mvk | ~(xh | pvk);
+            uint64_t mh = pvk & xh;
+            uint64_t high = k + 1 == blocks ? last : 1ULL << 63;
+            int hout = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+            ph <<= 1;
+            mh <<= 1;
+            if (hin < 0) mh |= 1; else if (hin > 0) ph |= 1;
+            pv[k] = mh | ~(xv | ph);
+            mv[k] = ph & xv;
+            hin = hout;
+        }
+        score += hin;
+    }
+    return score;
+}
+
+// A shared prefix or suffix never changes the distance; corrupted and repaired
+// texts differ from the original in a few places, so usually little is left.
+static long levenshtein(const CodePoints& a, const CodePoints& b) {
+    size_t begin = 0, ea = a.size(), eb = b.size();
+    while (begin < ea && begin < eb && a[begin] == b[begin]) begin++;
+    while (ea > begin && eb > begin && a[ea - 1] == b[eb - 1]) { ea--; eb--; }
+    size_t na = ea - begin, nb = eb - begin;
+    if (na <= nb) return myers(a.data() + begin, na, b.data() + begin, nb);
+    return myers(b.data() + begin, nb, a.data() + begin, na);
+}
+
+//-------------------------------------
+// 3. Results table processing
+//-------------------------------------
+struct Row {
+    long long id;
+    CodePoints original, broken, repaired;
+    bool has_repaired;                  // repaired distances are computed for this row
+    long old_ob, old_br, old_or;        // current column values (-2 = NULL)
+    long ob = -1, br = -1, orr = -1;
+};
+
+static long columnOr(sqlite3_stmt* st, int col, long null_value) {
+    return sqlite3_column_type(st, col) == SQLITE_NULL ? null_value : sqlite3_column_int64(st, col);
+}
+
+static CodePoints columnText(sqlite3_stmt* st, int col) {
+    const unsigned char* s = sqlite3_column_text(st, col);
+    return s ? decodeUtf8(s, sqlite3_column_bytes(st, col)) : CodePoints();
+}
+
+static int processDatabase(const std::string& path, const std::string& table, int threads, bool check) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::cerr << "Error: Could not open " << path << ": " << sqlite3_errmsg(db) << "\n";
+        sqlite3_close(db);
+        return 2;
+    }
+    sqlite3_busy_timeout(db, 10000);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Row> rows;
+    std::string select = "SELECT id, original_text, broken_text, repaired_text, distance_original_broken, "
+                         "distance_broken_repaired, distance_original_repaired FROM " + table;
+    sqlite3_stmt* st = nullptr;
+    if (sqlite3_prepare_v2(db, select.c_str(), -1, &st, nullptr) != SQLITE_OK) {
+        std::cerr << "Error: " << path << ": " << sqlite3_errmsg(db) << "\n";
+        sqlite3_close(db);
+        return 2;
+    }
+    while (sqlite3_step(st) == SQLITE_ROW) {
+        Row r;
+        r.id = sqlite3_column_int64(st, 0);
+        r.original = columnText(st, 1);
+        r.broken = columnText(st, 2);
+        r.repaired = columnText(st, 3);
+        r.old_ob = columnOr(st, 4, -2);
+        r.old_br = columnOr(st, 5, -2);
+        r.old_or = columnOr(st, 6, -2);
+        // -1 marks "no repair output" (see bm_single.py); keep it that way
+        r.has_repaired = sqlite3_column_type(st, 3) != SQLITE_NULL && r.old_br != -1 && r.old_or != -1;
+        rows.push_back(std::move(r));
+    }
+    sqlite3_finalize(st);
+
+    // Compute distances, rows handed out dynamically since lengths vary a lot
+    auto t1 = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i; (i = next.fetch_add(1)) < rows.size(); ) {
+            Row& r = rows[i];
+            r.ob = levenshtein(r.original, r.broken);
+            if (r.has_repaired) {
+                r.br = levenshtein(r.broken, r.repaired);
+                r.orr = levenshtein(r.original, r.repaired);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    auto t2 = std::chrono::steady_clock::now();
+
+    size_t changed = 0;
+    for (const Row& r : rows) {
+        if (r.ob != r.old_ob || r.br != r.old_br || r.orr != r.old_or) {
+            changed++;
+            if (check && changed <= 10) {
+                printf("[CHECK] %s id=%lld: stored (%ld, %ld, %ld) computed (%ld, %ld, %ld)\n", path.c_str(), r.id,
+                       r.old_ob, r.old_br, r.old_or, r.ob, r.br, r.orr);
+            }
+        }
+    }
+
+    int rc = 0;
+    if (!check && changed > 0) {
+        std::string update = "UPDATE " + table + " SET distance_original_broken = ?, distance_broken_repaired = ?, "
+                             "distance_original_repaired = ? WHERE id = ?";
+        sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+        if (sqlite3_prepare_v2(db, update.c_str(), -1, &st, nullptr) != SQLITE_OK) {
+            std::cerr << "Error: " << path << ": " << sqlite3_errmsg(db) << "\n";
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            sqlite3_close(db);
+            return 2;
+        }
+        for (const Row& r : rows) {
+            if (r.ob == r.old_ob && r.br == r.old_br && r.orr == r.old_or) continue;
+            sqlite3_bind_int64(st, 1, r.ob);
+            sqlite3_bind_int64(st, 2, r.br);
+            sqlite3_bind_int64(st, 3, r.orr);
+            sqlite3_bind_int64(st, 4, r.id);
+            if (sqlite3_step(st) != SQLITE_DONE) {
+                std::cerr << "Error: " << path << ": " << sqlite3_errmsg(db) << "\n";
+                rc = 2;
+                break;
+            }
+            sqlite3_reset(st);
+        }
+        sqlite3_finalize(st);
+        sqlite3_exec(db, rc == 0 ? "COMMIT" : "ROLLBACK", nullptr, nullptr, nullptr);
+    }
+    sqlite3_close(db);
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto secs = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+        return std::chrono::duration<double>(b - a).count();
+    };
+    printf("[edit_distance] %s: %zu rows, %zu %s (read %.2fs, compute %.2fs on %d threads, write %.2fs)\n",
+           path.c_str(), rows.size(), changed, check ? "differ" : "updated",
+           secs(t0, t1), secs(t1, t2), threads, secs(t2, t3));
+    if (check && changed > 0) rc = 1;
+    return rc;
+}
+
+//-------------------------------------
+// 4. Main function
+//-------------------------------------
+int main(int argc, char* argv[]) {
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    std::string table = "results";
+    bool check = false;
+    std::vector<std::string> dbs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-j" || arg == "--threads") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if ((arg == "-t" || arg == "--table") && i + 1 < argc) {
+            table = argv[++i];
+        } else if (arg == "--check") {
+            check = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            dbs.clear();
+            break;
+        } else {
+            dbs.push_back(arg);
+        }
+    }
+    if (dbs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-t table] [--check] <db> [db ...]\n"
+                  << "  --check   only compare the stored distances, exit 1 if any differ\n";
+        return 2;
+    }
+    if (threads < 1) threads = 1;
+
+    int rc = 0;
+    for (const auto& db : dbs) {
+        int r = processDatabase(db, table, threads, check);
+        if (r > rc) rc = r;
+    }
+    return rc;
+}
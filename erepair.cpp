@@ -1,286 +1,166 @@
-#include <iostream>
-#include <queue>
-#include <string>
-#include <vector>
-#include <functional>
-#include <fstream>
-#include <cctype>
-#include <set>
-#include <cstdlib>
-#include <random>
-#include <stdexcept>
-#include <math.h>   
-#include <unistd.h>    // for close(), getpid()
-#include <fcntl.h>     // for mkstemp
-#include <stdio.h>     // for mkstemp
-#include <sys/wait.h>  // for WIFEXITED, WEXITSTATUS
-
-int interations = 0;
-int success = 0;
-int failure = 0;
-int incomplete = 0;
-//-------------------------------------
-// 0. CharacterSet
-//-------------------------------------
-class CharacterSet {
-private:
-    std::set<char> valid_chars;
-
-public:
-    CharacterSet() {
-        initializeDefault();
-    }
-
-    void initializeDefault() {
-        valid_chars.clear();
-
-        std::vector<char> chars = { ')', '}', ']' };
-
-        for(auto c: chars){
-            valid_chars.insert(c);
-        }
-
-        for (int i = 33; i <= 126; ++i) {
-            char c = static_cast<char>(i);
-            if (std::find(chars.begin(), chars.end(), c) 
-                == chars.end()) 
-            {
-                valid_chars.insert(c);
-            }
-        }
-
-        valid_chars.insert('\n');
-        valid_chars.insert('\t');
-    }
-
-    std::set<char>::iterator begin() { return valid_chars.begin(); }
-    std::set<char>::iterator end() { return valid_chars.end(); }
-};
-
-//-------------------------------------
-// 1. ParseResult enum class
-//-------------------------------------
-enum class ParseResult { INCOMPLETE, CORRECT, INCORRECT };
-
 //-------------------------------------
-// Generate a unique temporary filename and create the file
-// Using mkstemp() ensures there is no conflict with existing files
+// erepair.cpp
+//
+// Command-line front end of librepair: repairs one file with a subject
+// command as the oracle and prints the oracle statistics.
+//
+// Build:  make erepair
+// Usage:  ./erepair [options] <parser_path> <input_file> <output_file>
 //-------------------------------------
-std::string generateTempFile()
-{
-    // "XXXXXX" will be replaced by mkstemp() with a unique string
-    char pattern[] = "/tmp/parser_inputXXXXXX";
-    int fd = mkstemp(pattern);
-    if (fd == -1) {
-        throw std::runtime_error("Failed to create temp file");
-    }
-    // We only create the file here and get the filename, then close the fd
-    close(fd);
-    return std::string(pattern);
-}
-
-//-------------------------------------
-// 2. External parser returning ParseResult
-//    Uses a unique temporary file name to avoid concurrency conflicts
-//-------------------------------------
-std::function<ParseResult(const std::string&)> createParser(const std::string& parser_path) {
-    return [parser_path](const std::string& input) -> ParseResult {
-        // Generate a unique temporary file
-        std::string temp_file;
-        try {
-            temp_file = generateTempFile();
-        } catch (const std::exception& e) {
-            std::cerr << "Error: " << e.what() << "\n";
-            return ParseResult::INCORRECT;
-        }
+#include "librepair.h"
 
-        // Write the input to the temporary file
-        {
-            std::ofstream temp_out(temp_file);
-            if (!temp_out.is_open()) {
-                std::cerr << "Error: Could not create temporary file." << std::endl;
-                return ParseResult::INCORRECT;
-            }
-            temp_out << input;
-        }
-        interations++;
-        // Call the external parser
-        // parser_path + " " + temp_file + " > /dev/null 2>&1"
-        std::string command = parser_path + " " + temp_file + " > /dev/null 2>&1";
-        int status = system(command.c_str());
-
-        ParseResult result = ParseResult::INCORRECT;
-        if (WIFEXITED(status)) {
-            int exit_code = WEXITSTATUS(status);
-            if (exit_code == 0) {
-                success++;
-                result = ParseResult::CORRECT;
-            } else if (exit_code == 1) {
-                failure++;
-                result = ParseResult::INCORRECT;
-            } else if (exit_code == 255) {
-                incomplete++;
-                result = ParseResult::INCOMPLETE;
-            } else {
-                failure++;
-                // Handle more exit codes if needed
-                result = ParseResult::INCORRECT;
-            }
-        }
-
-        // Remove the temporary file when done to avoid leftovers
-        std::remove(temp_file.c_str());
-        return result;
-    };
-}
-
-//-------------------------------------
-// 3. BSearch function
-//-------------------------------------
-int BSearch(const std::string& s,
-            const std::function<ParseResult(const std::string&)>& parser,
-            int left = 0) {
-    int right = static_cast<int>(s.size());
-    // If the entire string is not INCORRECT, return directly
-    if (parser(s.substr(0, right)) != ParseResult::INCORRECT) return right;
-
-    // Binary search for boundary
-    while (left < right - 1) {
-        int middle = (left + right) / 2;
-        if (parser(s.substr(0, middle)) != ParseResult::INCORRECT) {
-            left = middle;
-        } else {
-            right = middle;
-        }
-    }
-
-    return left;
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <stdio.h>
+#include <getopt.h>    // for getopt_long
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options] <parser_path> <input_file> <output_file>\n"
+              << "  -q, --quiet                 no log output\n"
+              << "  -v, --verbose               debug messages (repeat for trace level)\n"
+              << "  -t, --trace <file>          dump every explored string to <file>\n"
+              << "  -p, --progress <seconds>    interval between progress lines (default 1)\n"
+              << "      --no-index              ask the parser every question (no answer reuse or prefix inference)\n"
+              << "      --monotone              infer answers from prefixes for any subject; by default only\n"
+              << "                              sexp is trusted to be prefix-monotone\n"
+              << "      --bucket-order <order>  order within an edit distance: fifo (default) or boundary\n"
+              << "      --no-substitution       only delete and insert at the boundary\n"
+              << "  -m, --memory-limit <MiB>    spill high-distance frontier states to disk beyond this\n"
+              << "      --speculate <k>         run the popped state's and the next k states' first checks ahead\n"
+              << "  -j, --jobs <n>              speculative parser workers (default: number of CPUs)\n"
+              << "      --precheck <format>     in-process checks before the parser: json, lisp, dot, c or none\n"
+              << "                              (default: from the parser's name)\n"
+              << "      --persistent <n>        keep the subject running in its --persistent mode, restarted\n"
+              << "                              every n inputs\n"
+              << "      --next-bytes            ask the persistent subject (or the --region automaton) which\n"
+              << "                              bytes may follow the boundary and only insert or substitute those\n"
+              << "      --region <format>       regex format (Date, Time, URL, ISBN, IPv4, IPv6, FilePath): find\n"
+              << "                              the boundary and reject dead candidates with its automaton\n"
+              << "      --portfolio             race DRepair variants and span deletion on separate threads,\n"
+              << "                              sharing oracle answers; the closest repair wins\n"
+              << "      --shadow <command>      re-check a sample of the fast-path answers against this subject\n"
+              << "      --shadow-rate <p>       fraction of the fast-path answers to re-check (default 0.01)\n"
+              << "      --shadow-log <file>     append mismatches to <file> (default: stderr)\n";
 }
 
-//-------------------------------------
-// 4. DRepair function
-//-------------------------------------
-std::string DRepair(const std::string& input,
-                    const std::function<ParseResult(const std::string&)>& parser) {
-    struct State {
-        std::string str;        // current string
-        int boundary;           // current boundary
-        int editingDistance;    // accumulated editing distance (lower is higher priority)
-
-        bool operator>(const State& other) const {
-            return editingDistance > other.editingDistance;
-        }
+int main(int argc, char* argv[]) {
+    static const struct option long_options[] = {
+        {"quiet",    no_argument,       nullptr, 'q'},
+        {"verbose",  no_argument,       nullptr, 'v'},
+        {"trace",    required_argument, nullptr, 't'},
+        {"progress", required_argument, nullptr, 'p'},
+        {"no-index", no_argument,       nullptr, 'N'},
+        {"monotone", no_argument,       nullptr, 'O'},
+        {"bucket-order", required_argument, nullptr, 'B'},
+        {"no-substitution", no_argument,    nullptr, 'S'},
+        {"memory-limit", required_argument, nullptr, 'm'},
+        {"speculate", required_argument,    nullptr, 'K'},
+        {"jobs",     required_argument,     nullptr, 'j'},
+        {"precheck", required_argument,     nullptr, 'P'},
+        {"persistent", required_argument,   nullptr, 'I'},
+        {"next-bytes", no_argument,         nullptr, 'X'},
+        {"region",   required_argument,     nullptr, 'G'},
+        {"portfolio", no_argument,          nullptr, 'F'},
+        {"shadow",   required_argument,     nullptr, 'H'},
+        {"shadow-rate", required_argument,  nullptr, 'R'},
+        {"shadow-log", required_argument,   nullptr, 'L'},
+        {nullptr, 0, nullptr, 0}
     };
-
-    // Min-heap, with smaller editingDistance having higher priority
-    std::priority_queue<State, std::vector<State>, std::greater<State>> pq;
-
-    // Initial boundary
-    int boundary = BSearch(input, parser, 0);
-    pq.push({input, boundary, 0});
-
-    CharacterSet valid_chars;
-
-    while (!pq.empty()) {
-        State current = pq.top();
-        pq.pop();
-        std::cout << "Dealing with current string:\n" << current.str << "\n\n";        // If the entire string is CORRECT, return directly
-        if (parser(current.str) == ParseResult::CORRECT) {
-            return current.str;
-        }
-
-        // 1) Try deleting the character at the boundary
-        if (current.boundary < static_cast<int>(current.str.size())) {
-            std::string new_str = current.str;
-            new_str.erase(current.boundary, 1);
-            if (parser(new_str)== ParseResult::CORRECT){
-                return new_str;
-            }
-            int new_boundary = BSearch(new_str, parser);
-
-            if(new_boundary - current.boundary > 0){
-                // Believe this corruption has been healed, handling next corruption
-                std::priority_queue<State, std::vector<State>, std::greater<State>> empty;
-                pq.swap(empty);
-                pq.push({new_str, new_boundary, current.editingDistance + 1});
-                continue;
-            }
-            pq.push({new_str, new_boundary, current.editingDistance + 1});
-        }
-
-        // 2) Try inserting various valid characters at the boundary
-        bool flag = false;
-        bool all_accepted = true;
-        for (char c : valid_chars) {
-            std::string new_str = current.str;
-            new_str.insert(current.boundary, 1, c);
-
-            if(parser(new_str) == ParseResult::CORRECT){
-                return new_str;
-            }
-            int new_boundary = BSearch(new_str, parser);
-            if (new_boundary - current.boundary > 1) {
-                // Believe this corruption has been healed, handling next corruption 
-                std::priority_queue<State, std::vector<State>, std::greater<State>> empty;
-                pq.swap(empty);
-                pq.push({new_str, new_boundary, current.editingDistance + 1});
-                break;
-            } else if (new_boundary - current.boundary == 1) {
-                pq.push({new_str, new_boundary, current.editingDistance + 1});
-                if(c!='\n' && c!='\t'){
-                    flag = true;
-                }
+    repair_config config;
+    repair_config_init(&config);
+    int log_level = REPAIR_LOG_INFO;
+    double progress_interval = 1.0;
+    const char* trace_path = nullptr;
+    const char* precheck = "auto";
+    int opt;
+    while ((opt = getopt_long(argc, argv, "qvt:p:m:j:", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 'q':
+            log_level = REPAIR_LOG_QUIET;
+            break;
+        case 'v':
+            log_level = log_level < REPAIR_LOG_DEBUG ? REPAIR_LOG_DEBUG : REPAIR_LOG_TRACE;
+            break;
+        case 't':
+            trace_path = optarg;
+            break;
+        case 'p':
+            progress_interval = atof(optarg);
+            break;
+        case 'N':
+            config.use_index = 0;
+            break;
+        case 'O':
+            config.use_index = 2;
+            break;
+        case 'm':
+            config.memory_limit = static_cast<size_t>(atof(optarg) * (1 << 20));
+            break;
+        case 'K':
+            config.speculate = atoi(optarg);
+            break;
+        case 'j':
+            config.jobs = atoi(optarg);
+            break;
+        case 'P':
+            precheck = optarg;
+            break;
+        case 'I':
+            config.persistent = atoi(optarg);
+            break;
+        case 'X':
+            config.next_bytes = 1;
+            break;
+        case 'G':
+            config.region = optarg;
+            break;
+        case 'F':
+            config.portfolio = 1;
+            break;
+        case 'H':
+            config.shadow_path = optarg;
+            break;
+        case 'R':
+            config.shadow_rate = atof(optarg);
+            break;
+        case 'L':
+            config.shadow_log = optarg;
+            break;
+        case 'S':
+            config.substitute = 0;
+            break;
+        case 'B':
+            if (strcmp(optarg, "fifo") == 0) {
+                config.bucket_order = REPAIR_ORDER_FIFO;
+            } else if (strcmp(optarg, "boundary") == 0) {
+                config.bucket_order = REPAIR_ORDER_BOUNDARY;
             } else {
-                all_accepted = false;
-                continue;
-            }
-        }
-        if (!flag) {
-            if(parser(current.str.substr(0, current.boundary)) == ParseResult::CORRECT){
-                return current.str.substr(0, current.boundary);
+                usage(argv[0]);
+                return 1;
             }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
         }
-        if (all_accepted && current.boundary == current.str.size()) {
-            std::cout<<"All accepted"<<std::endl;
-            std::string temp  = current.str;
-            for(int i=33;i<=126;i++){
-                char c = static_cast<char>(i);
-                temp.push_back(c);
-            }
-            temp.push_back('a'); //watchman
-            int temp_boundary = BSearch(temp, parser);
-            if(temp_boundary!=temp.size()-1){
-
-                char c = temp[temp_boundary-1];
-                // std::cout<<"c: "<<c<<std::endl;
-                // std::cout<<temp<<std::endl;
-                current.str.push_back(c);
-                int new_boundary = BSearch(current.str, parser);
-                pq.push({current.str, new_boundary, current.editingDistance-1}); // priority is not increased
-                // std::priority_queue<State, std::vector<State>, std::greater<State>> empty;
-                // pq.swap(empty);
-                // pq.push({current.str, new_boundary, current.editingDistance + 1});
-            } 
-        }
+    }
+    if (argc - optind < 3) {
+        usage(argv[0]);
+        return 1;
     }
 
-    // No feasible solution found
-    return "";
-}
+    std::string parser_path    = argv[optind];
+    std::string input_filename = argv[optind + 1];
+    std::string output_filename= argv[optind + 2];
 
-//-------------------------------------
-// 5. Main function
-//-------------------------------------
-int main(int argc, char* argv[]) {
-    if (argc < 4) {
-        std::cerr << "Usage: " << argv[0] << " <parser_path> <input_file> <output_file>\n";
+    if (repair_set_logging(log_level, progress_interval, trace_path) != 0) {
+        std::cerr << "Error: Could not open trace file " << trace_path << std::endl;
         return 1;
     }
 
-    std::string parser_path    = argv[1];
-    std::string input_filename = argv[2];
-    std::string output_filename= argv[3];
-
     std::ifstream input_file(input_filename);
     if (!input_file.is_open()) {
         std::cerr << "Error: Could not open file " << input_filename << std::endl;
@@ -291,24 +171,74 @@ int main(int argc, char* argv[]) {
     std::string input((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>());
     input_file.close();
 
-    // Create the parser and run DRepair
-    auto parser = createParser(parser_path);
-    std::string result = DRepair(input, parser);
+    // Create the repairer and run DRepair
+    config.parser_path = parser_path.c_str();
+    config.precheck = strcmp(precheck, "auto") == 0 ? nullptr : precheck;
+    repairer* r = repair_create(&config);
+    if (!r) {
+        std::cerr << "Error: " << repair_create_error() << std::endl;
+        usage(argv[0]);
+        return 1;
+    }
+    char* result = nullptr;
+    size_t result_len = 0;
+    repair_stats stats;
+    repair_stats_init(&stats);
+    int rc = repair_run(r, input.data(), input.size(), &result, &result_len, &stats);
+    if (rc < 0) {
+        std::cerr << "Error: " << repair_last_error(r) << std::endl;
+        repair_destroy(r);
+        return 1;
+    }
 
-    if (!result.empty()) {
+    if (rc == 0) {
         std::ofstream out_file(output_filename);
         if (!out_file.is_open()) {
             std::cerr << "Error: Could not open output file " << output_filename << std::endl;
+            repair_free(result);
+            repair_destroy(r);
             return 1;
         }
-        out_file << result;
+        out_file.write(result, static_cast<std::streamsize>(result_len));
         out_file.close();
 
-        std::cout << "After repair:\n" << result << "\n";
         std::cout << "Repaired string saved to: " << output_filename << std::endl;
     } else {
         std::cout << "No valid repair found." << std::endl;
     }
-    printf("*** Number of required oracle runs: %lld correct: %lld incorrect: %lld \n", (long long)interations, (long long)success, (long long)failure);
+    repair_free(result);
+
+    if (config.use_index) {
+        printf("*** Prefix index: inferred incorrect: %lld inferred viable: %lld cached: %lld nodes: %zu bytes: %zu ***\n",
+               stats.inferred_bad, stats.inferred_viable, stats.cached, stats.index_nodes, stats.index_bytes);
+    }
+    if (stats.prechecked) {
+        printf("*** Precheck (%s): skipped oracle runs: %lld ***\n", stats.precheck, stats.prechecked);
+    }
+    if (config.speculate >= 0 && !config.portfolio) {
+        printf("*** Speculation: runs: %lld useful: %lld wasted: %lld cancelled: %lld ***\n",
+               stats.speculative_runs, stats.speculative_useful, stats.speculative_wasted, stats.speculative_cancelled);
+    }
+    if (config.portfolio) {
+        printf("*** Portfolio: winner: %s shared answers: %lld ***\n", *stats.strategy ? stats.strategy : "none",
+               stats.shared_hits);
+    }
+    if (config.region) {
+        printf("*** Region: scans: %lld skipped checks: %lld ***\n", stats.region_scans, stats.region_skipped);
+    }
+    repair_shadow_stats shadow;
+    repair_shadow_stats_init(&shadow);
+    if (repair_shadow_report(r, 1, &shadow) == 0) {
+        printf("*** Shadow: sampled: %lld checked: %lld mismatches: %lld dropped: %lld ***\n",
+               shadow.sampled, shadow.checked, shadow.mismatches, shadow.dropped);
+    }
+    // Next to the oracle runs: the parses the subject ran in their place
+    if (config.next_bytes) {
+        printf("*** Next bytes: queries: %lld skipped candidates: %lld subject parses: %lld ***\n",
+               stats.next_queries, stats.next_skipped, stats.next_parses);
+    }
+    printf("*** Number of required oracle runs: %lld correct: %lld incorrect: %lld \n",
+           stats.oracle_runs, stats.correct, stats.incorrect);
+    repair_destroy(r);
     return 0;
 }
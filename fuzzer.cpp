@@ -2,12 +2,20 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <memory>
 #include <format>
 #include <queue>
+#include <tuple>
 #include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "json.hpp"
 
 using namespace std;
@@ -25,12 +33,13 @@ struct Node
     string name;
     Type tp; // terminal, non_terminal, expression
     vector<Node *> subnode;
+    vector<unsigned> steps; // derivation steps to each subnode: 1, more once inlined
 };
 
 class Grammar
 {
 public:
-    Grammar(json &content, unsigned maxdepth)
+    Grammar(json &content, unsigned maxdepth, bool normalized = true)
     {
         map<string, vector<vector<string>>> contentInstd = content.template get<map<string, vector<vector<string>>>>(); // get the content from the json file
         for (auto key : contentInstd)
@@ -53,6 +62,7 @@ public:
                         newnode = mp[expression[0]];
                     }
                     mp[rule.first]->subnode.push_back(newnode);
+                    mp[rule.first]->steps.push_back(1);
                     continue;
                 }
                 Node *optnodes = allocate_node("", Type::expression);
@@ -68,16 +78,88 @@ public:
                         newnode = mp[option];
                     }
                     optnodes->subnode.push_back(newnode);
+                    optnodes->steps.push_back(1);
                 }
                 mp[rule.first]->subnode.push_back(optnodes);
+                mp[rule.first]->steps.push_back(1);
             }
         }
         this->start = mp["<start>"];
         this->maxdepth = maxdepth;
+        // Shortcuts come from the grammar as written, so that normalizing
+        // does not change what a derivation cut off at -d produces
         this->getshortcut();
+        if (normalized)
+        {
+            this->normalize();
+        }
     };
 
+    // Write the generator with -d and -c as its defaults
     void JIT(string file, int count)
+{
+    string code = "#define DEFAULT_DEPTH " + to_string(this->maxdepth) + "\n";
+    code += "#define DEFAULT_COUNT " + to_string(count) + "\n";
+    code += generate();
+    std::ofstream ofs(file, std::ofstream::out | std::ofstream::trunc);
+    ofs << code;
+    ofs.close();
+    std::cout << "Code written to file successfully." << std::endl;
+}
+
+    // Compile the generator into dir, named by a hash of its source and the
+    // compiler command, unless it is there already; depth and count are
+    // arguments of the generator, so they do not change the source.
+    // Returns the path of the executable, or "" if it does not compile.
+    string compile(string dir, string cc)
+{
+    string code = generate();
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)fnv1a(cc + "\n" + code));
+    string binary = dir + "/gen_" + hex;
+    if (access(binary.c_str(), X_OK) == 0) {
+        return binary;
+    }
+    if (!makeDirs(dir)) {
+        std::cerr << "Failed to create the cache directory " << dir << ": " << strerror(errno) << std::endl;
+        return "";
+    }
+    // concurrent runs may compile the same generator: each writes and
+    // compiles its own files, and the renames are atomic
+    string tmp = binary + ".tmp" + to_string(getpid());
+    string source = tmp + ".c";
+    std::ofstream ofs(source, std::ofstream::out | std::ofstream::trunc);
+    ofs << code;
+    ofs.close();
+    string command = cc + " -o '" + tmp + "' '" + source + "'";
+    if (!ofs || std::system(command.c_str()) != 0 || rename(tmp.c_str(), binary.c_str()) != 0) {
+        std::cerr << "Failed to compile the generator: " << command << std::endl;
+        remove(tmp.c_str());
+        remove(source.c_str());
+        return "";
+    }
+    // kept next to the binary for reading
+    if (rename(source.c_str(), (binary + ".c").c_str()) != 0) remove(source.c_str());
+    return binary;
+}
+
+    // mkdir -p: true if dir exists (as a directory) afterwards
+    static bool makeDirs(const string& dir)
+{
+    for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+        string part = dir.substr(0, slash);
+        struct stat st;
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (stat(part.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            errno = ENOTDIR;
+            return false;
+        }
+        if (slash == string::npos) return true;
+    }
+}
+
+    // The generator's source: the same for the same normalized grammar
+    string generate()
 {
     string code = R"(#include <stdio.h>
 #include <stdlib.h>
@@ -87,9 +169,13 @@ public:
 #include <stdint.h>  // For uintptr_t
 #include <unistd.h>  // For getpid()
 #define BUFFER_SIZE 512*1024*1024   // buffer for storing text
-)";
-    code += "#define MAX_DEPTH " + to_string(this->maxdepth) + "\n";
-    code += R"(typedef struct {
+#ifndef DEFAULT_DEPTH
+#define DEFAULT_DEPTH 1
+#endif
+#ifndef DEFAULT_COUNT
+#define DEFAULT_COUNT 1
+#endif
+typedef struct {
     char data[BUFFER_SIZE];
     unsigned top;
 } Buffer;
@@ -118,19 +204,30 @@ Inst *PC;
     branch = seed % l
 
 bool endless = false;
+unsigned max_depth = DEFAULT_DEPTH;
 
 )";
 
+    // Terminals are written in place by their callers; only the start
+    // symbol gets a function whatever it is
+    vector<Node *> live;
+    for (auto &x : reachable()) {
+        if (x->tp != Type::terminal || x == this->start) {
+            ids[x] = live.size();
+            live.push_back(x);
+        }
+    }
+
     // Create the signature of the functions
-    for (auto &x : nodes) {
-        code += "void func_" + to_string(reinterpret_cast<uintptr_t>(x)) + "(unsigned depth);\n";
+    for (auto &x : live) {
+        code += "void func_" + to_string(ids[x]) + "(unsigned depth);\n";
     }
 
     // Create function definitions
-    for (auto &x: nodes) {
-        code += "void func_" + to_string(reinterpret_cast<uintptr_t>(x)) + "(register unsigned depth) {\n";
+    for (auto &x: live) {
+        code += "void func_" + to_string(ids[x]) + "(register unsigned depth) {\n";
         if (x->tp == Type::non_terminal) {
-            code += "    if (depth > MAX_DEPTH) {\n";
+            code += "    if (depth > max_depth) {\n";
             for (int j = 0; j < this->shortcut[x].size(); j++) {
                 code += "        extend(" + to_string((unsigned)shortcut[x][j]) + ");\n";
             }
@@ -140,19 +237,19 @@ bool endless = false;
             code += "    switch (branch) {\n";
             for (int j = 0; j < x->subnode.size(); j++) {
                 code += "        case " + to_string(j) + ":\n";
-                code += "            func_" + to_string(reinterpret_cast<uintptr_t>(x->subnode[j])) + "(depth+1);\n";
+                code += call(x->subnode[j], x->steps[j], "            ");
                 code += "        break;\n";
             }
             code += "    }\n";
         } else if (x->tp == Type::expression) {
-            code += "    if (depth > MAX_DEPTH) {\n";
+            code += "    if (depth > max_depth) {\n";
             for (int j = 0; j < this->shortcut[x].size(); j++) {
                 code += "        extend(" + to_string((unsigned)shortcut[x][j]) + ");\n";
             }
             code += "        return;\n";
             code += "    }\n";
-            for (auto &k : x->subnode) {
-                code += "    func_" + to_string(reinterpret_cast<uintptr_t>(k)) + "(depth+1);\n";
+            for (int j = 0; j < x->subnode.size(); j++) {
+                code += call(x->subnode[j], x->steps[j], "    ");
             }
         } else if (x->tp == Type::terminal) {
             for (int j = 0; j < x->name.size(); j++) {
@@ -163,8 +260,21 @@ bool endless = false;
         code += "}\n";
     }
 
-    code += "int main(void) {\n";
-    code += "    static unsigned count = " + to_string(count) + ";\n";
+    code += R"(int main(int argc, char *argv[]) {
+    long count = DEFAULT_COUNT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            max_depth = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--endless") == 0) {
+            count = -1;
+        } else {
+            fprintf(stderr, "Usage: %s [-d <depth>] [-c <count> | --endless]\n", argv[0]);
+            return 1;
+        }
+    }
+)";
 
     // Use high-resolution time and process ID for better randomness
     code += R"(
@@ -175,28 +285,27 @@ bool endless = false;
     seed = timeSeed ^ pid; // Combine time and PID for the seed
 )";
 
-    if (count == -1) {
-        code += "    endless = true;\n";
-    }
+    code += "    endless = count < 0;\n";
     code += "    while (endless || (count > 0)) {\n";
-    code += "        func_" + to_string(reinterpret_cast<uintptr_t>(this->start)) + "(1);\n";
+    code += "        func_" + to_string(ids[this->start]) + "(" + to_string(this->startDepth) + ");\n";
     code += "        count--;\n";
     code += "        printf(\"%.*s\\n\", (int)buffer.top, buffer.data);\n";
     code += "        clean();\n";
     code += "    }\n";
     code += "    return 0;\n";
     code += "}\n";
-
-    std::ofstream ofs(file, std::ofstream::out | std::ofstream::trunc);
-    ofs << code;
-    ofs.close();
-    std::cout << "Code written to file successfully." << std::endl;
+    return code;
 }
     private:
         vector<Node *> nodes;
         map<string, Node *> mp;
+        map<Node *, Node *> alias;     // node -> the node that replaces it
+        map<Node *, unsigned> aliasSteps; // and the derivation steps it skips
+        map<string, Node *> terminals; // terminals by text, merged ones included
+        map<Node *, int> ids;          // function numbers in the generated code
         int count = 0;
         Node *start;
+        unsigned startDepth = 1;       // depth the start symbol is called with
         unsigned maxdepth;
         map<Node *, string> shortcut;
         Node *allocate_node(string name, Type tp)
@@ -216,6 +325,243 @@ bool endless = false;
             return newnode;
         }
 
+        static uint64_t fnv1a(const string &text)
+        {
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char c : text)
+            {
+                hash = (hash ^ c) * 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        // The derivation of k, `steps` levels down, in generated code: the
+        // bytes of a terminal, a call for anything else
+        string call(Node *k, unsigned steps, string indent)
+        {
+            string code;
+            if (k->tp == Type::terminal)
+            {
+                for (int j = 0; j < k->name.size(); j++)
+                {
+                    code += indent + "extend(" + to_string((unsigned)k->name[j]) + ");\n";
+                }
+                return code;
+            }
+            return indent + "func_" + to_string(ids[k]) + "(depth+" + to_string(steps) + ");\n";
+        }
+
+        vector<Node *> reachable()
+        {
+            vector<Node *> order = {this->start};
+            set<Node *> seen = {this->start};
+            for (int i = 0; i < order.size(); i++)
+            {
+                for (auto &j : order[i]->subnode)
+                {
+                    if (seen.insert(j).second)
+                    {
+                        order.push_back(j);
+                    }
+                }
+            }
+            return order;
+        }
+
+        // The node that replaces n; adds the derivation steps in between to *steps
+        Node *resolve(Node *n, unsigned *steps = nullptr)
+        {
+            set<Node *> seen;
+            while (alias.count(n) && seen.insert(n).second)
+            {
+                if (steps)
+                {
+                    *steps += aliasSteps[n];
+                }
+                n = alias[n];
+            }
+            return n;
+        }
+
+        Node *terminal(const string &text)
+        {
+            if (terminals.count(text))
+            {
+                return terminals[text];
+            }
+            Node *newnode = new Node();
+            newnode->tp = Type::terminal;
+            newnode->name = text;
+            nodes.push_back(newnode);
+            terminals[text] = newnode;
+            shortcut[newnode] = text;
+            return newnode;
+        }
+
+        // Rewrite the grammar into one that derives the same strings with the
+        // same probabilities in fewer steps:
+        //  - a rule with a single alternative is replaced by that alternative,
+        //    so chains of unit rules disappear
+        //  - an expression takes over the children of the expressions in it
+        //    and adjacent terminals become one terminal
+        //  - equivalent nodes are shared (deduplicate)
+        // A call into inlined code passes the depth the skipped steps would
+        // have reached, so -d cuts derivations off where it did before.
+        void normalize()
+        {
+            for (auto &i : nodes)
+            {
+                if (i->tp == Type::terminal)
+                {
+                    terminals.emplace(i->name, i);
+                }
+            }
+            for (auto &i : nodes)
+            {
+                if (i->tp == Type::non_terminal && i->subnode.size() == 1 && i->subnode[0] != i)
+                {
+                    alias[i] = i->subnode[0];
+                    aliasSteps[i] = i->steps[0];
+                }
+            }
+            set<Node *> done, active;
+            vector<Node *> all = nodes; // flatten() may add terminals
+            for (auto &i : all)
+            {
+                if (i->tp == Type::expression)
+                {
+                    flatten(i, done, active);
+                }
+            }
+            for (auto &i : nodes)
+            {
+                for (int j = 0; j < i->subnode.size(); j++)
+                {
+                    i->subnode[j] = resolve(i->subnode[j], &i->steps[j]);
+                }
+            }
+            this->start = resolve(this->start, &this->startDepth);
+            deduplicate();
+        }
+
+        void flatten(Node *x, set<Node *> &done, set<Node *> &active)
+        {
+            if (done.count(x))
+            {
+                return;
+            }
+            active.insert(x);
+            vector<Node *> flat;
+            vector<unsigned> flatSteps;
+            for (int j = 0; j < x->subnode.size(); j++)
+            {
+                unsigned steps = x->steps[j];
+                Node *k = resolve(x->subnode[j], &steps);
+                if (k->tp == Type::expression && !active.count(k))
+                {
+                    flatten(k, done, active);
+                    k = resolve(k, &steps);
+                    if (k->tp == Type::expression)
+                    {
+                        for (int c = 0; c < k->subnode.size(); c++)
+                        {
+                            flat.push_back(k->subnode[c]);
+                            flatSteps.push_back(steps + k->steps[c]);
+                        }
+                        continue;
+                    }
+                }
+                flat.push_back(k);
+                flatSteps.push_back(steps);
+            }
+            // terminals do not look at the depth, so merged ones keep any
+            vector<Node *> merged;
+            vector<unsigned> mergedSteps;
+            for (int j = 0; j < flat.size(); j++)
+            {
+                Node *k = flat[j];
+                if (k->tp != Type::terminal)
+                {
+                    merged.push_back(k);
+                    mergedSteps.push_back(flatSteps[j]);
+                }
+                else if (!merged.empty() && merged.back()->tp == Type::terminal)
+                {
+                    merged.back() = terminal(merged.back()->name + k->name);
+                }
+                else if (!k->name.empty())
+                {
+                    merged.push_back(k);
+                    mergedSteps.push_back(flatSteps[j]);
+                }
+            }
+            x->subnode = merged;
+            x->steps = mergedSteps;
+            active.erase(x);
+            done.insert(x);
+            if (merged.size() == 1)
+            {
+                alias[x] = merged[0];
+                aliasSteps[x] = mergedSteps[0];
+            }
+            else if (merged.empty())
+            {
+                alias[x] = terminal("");
+            }
+        }
+
+        // Nodes of the same type, text and shortcut whose children are
+        // equivalent and as many steps down position by position are
+        // equivalent.  Partition refinement finds them for recursive rules
+        // too; every class keeps its first node.
+        void deduplicate()
+        {
+            map<Node *, int> cls;
+            map<tuple<int, string, bool, string>, int> initial;
+            for (auto &i : nodes)
+            {
+                bool cut = shortcut.count(i);
+                auto key = make_tuple((int)i->tp, i->tp == Type::terminal ? i->name : string(),
+                                      cut, cut ? shortcut[i] : string());
+                cls[i] = initial.emplace(key, initial.size()).first->second;
+            }
+            size_t classes = initial.size();
+            while (1)
+            {
+                map<vector<int>, int> signature;
+                map<Node *, int> next;
+                for (auto &i : nodes)
+                {
+                    vector<int> sig = {cls[i]};
+                    for (int j = 0; j < i->subnode.size(); j++)
+                    {
+                        sig.push_back(cls[i->subnode[j]]);
+                        sig.push_back(i->steps[j]);
+                    }
+                    next[i] = signature.emplace(sig, signature.size()).first->second;
+                }
+                cls = next;
+                if (signature.size() == classes)
+                {
+                    break;
+                }
+                classes = signature.size();
+            }
+            map<int, Node *> first;
+            for (auto &i : nodes)
+            {
+                first.emplace(cls[i], i);
+            }
+            for (auto &i : nodes)
+            {
+                for (auto &j : i->subnode)
+                {
+                    j = first[cls[j]];
+                }
+            }
+            this->start = first[cls[this->start]];
+        }
+
         void getshortcut()
         {
             for (auto &i : nodes)
@@ -284,6 +630,9 @@ int main(int argc, char *argv[])
     std::string path;
     std::string outputFile;
     bool show = false;
+    bool normalized = true;
+    std::string cacheDir;
+    std::string cc = "cc -O2";
     for (int i = 1; i < argc; i++)
     {
         std::string arg = argv[i];
@@ -303,26 +652,62 @@ int main(int argc, char *argv[])
         {
             count = std::atoi(argv[++i]);
         }
+        else if (arg == "--cache" && i + 1 < argc)
+        {
+            cacheDir = argv[++i];
+        }
+        else if (arg == "--cc" && i + 1 < argc)
+        {
+            cc = argv[++i];
+        }
+        else if (arg == "--no-normalize")
+        {
+            normalized = false;
+        }
         else if (arg == "--endless")
         {
             count = -1;
         }
         else if (arg == "--help")
         {
-            std::cerr << "Usage: " << argv[0] << " -d <number> -p <path> -o <output file> -c <count of loops>" << std::endl;
+            std::cerr << "Usage: " << argv[0] << " -d <number> -p <path> (-o <output file> | --cache <dir> [--cc <compiler command>]) -c <count of loops> [--no-normalize]" << std::endl;
             return 1;
         }
     }
 
-    if (depth == 0 || path.empty() || outputFile.empty())
+    if (depth == 0 || path.empty() || (outputFile.empty() && cacheDir.empty()))
     {
-        std::cerr << "Usage: " << argv[0] << " -d <number> -p <path> -o <output file> [-c <count of loops> | --endless]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " -d <number> -p <path> (-o <output file> | --cache <dir> [--cc <compiler command>]) [-c <count of loops> | --endless] [--no-normalize]" << std::endl;
         return 1;
     }
 
     std::ifstream f(path);
     json content = json::parse(f);
-    Grammar gram = Grammar(content, depth);
-    gram.JIT(outputFile, count);
+    Grammar gram = Grammar(content, depth, normalized);
+    if (!outputFile.empty())
+    {
+        gram.JIT(outputFile, count);
+    }
+    if (!cacheDir.empty())
+    {
+        // run the cached generator in place of this process
+        std::string binary = gram.compile(cacheDir, cc);
+        if (binary.empty())
+        {
+            return 1;
+        }
+        std::string depthArg = std::to_string(depth);
+        std::string countArg = std::to_string(count);
+        if (count == -1)
+        {
+            execl(binary.c_str(), binary.c_str(), "-d", depthArg.c_str(), "--endless", (char *)NULL);
+        }
+        else
+        {
+            execl(binary.c_str(), binary.c_str(), "-d", depthArg.c_str(), "-c", countArg.c_str(), (char *)NULL);
+        }
+        std::cerr << "Failed to run " << binary << std::endl;
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,2203 @@
+//-------------------------------------
+// librepair.cpp
+//
+// The repair engine behind erepair (see librepair.h for the C interface):
+// the oracle with its prefix index, prechecks and speculative workers, the
+// boundary search, and DRepair over a bucket-queue frontier (alone, or
+// racing other strategies in a portfolio).
+//-------------------------------------
+#include "librepair.h"
+#include "validators/regex_region.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+#include <functional>
+#include <fstream>
+#include <cctype>
+#include <set>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <cerrno>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <math.h>   
+#include <unistd.h>    // for close(), getpid()
+#include <fcntl.h>     // for mkstemp
+#include <stdio.h>     // for mkstemp
+#include <sys/wait.h>  // for WIFEXITED, WEXITSTATUS
+#include <sys/mman.h>  // for mmap (frontier spill file)
+#include <sys/socket.h>  // for socketpair (persistent subjects)
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+#include <bitset>
+
+// Everything but the C interface stays internal to the library
+namespace {
+
+//-------------------------------------
+// Logging
+//   Messages go to stderr when their level is enabled (default INFO).
+//   The progress line is rate-limited to one per progress_interval seconds.
+//   Full strings are only written in trace mode, and only to the trace file.
+//   Portfolio strategies log from their own threads.
+//-------------------------------------
+enum class LogLevel { QUIET, INFO, DEBUG, TRACE };
+
+class Logger {
+public:
+    LogLevel level;
+    double progress_interval = 1.0;   // seconds between progress lines
+
+    explicit Logger(LogLevel level = LogLevel::INFO) : level(level) {}
+
+    bool enabled(LogLevel l) const { return level != LogLevel::QUIET && l <= level; }
+
+    bool openTrace(const std::string& path) {
+        if (trace_out.is_open()) trace_out.close();
+        trace_out.open(path);
+        return trace_out.is_open();
+    }
+
+    void log(LogLevel l, const std::string& message) {
+        if (!enabled(l)) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::cerr << "[erepair] " << message << "\n";
+    }
+
+    // Full text dump of a string, trace mode only
+    void trace(const std::string& what, const std::string& text) {
+        if (!trace_out.is_open()) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        trace_out << what << ":\n" << text << "\n\n";
+    }
+
+    // Progress line: popped states, frontier size, boundary, edit distance, oracle rate
+    void progress(long long states, size_t queued, int boundary, size_t length, int distance, long long calls,
+                  bool force = false) {
+        if (!enabled(LogLevel::INFO)) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        double since_last = std::chrono::duration<double>(now - last_time).count();
+        if (!force && since_last < progress_interval) return;
+        double elapsed = std::chrono::duration<double>(now - start_time).count();
+        double rate = since_last > 0 ? (calls - last_calls) / since_last : 0.0;
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "[progress] %.1fs states: %lld queued: %zu boundary: %d/%zu distance: %d oracle: %lld (%.1f calls/s)",
+                 elapsed, states, queued, boundary, length, distance, calls, rate);
+        std::cerr << line << "\n";
+        last_time = now;
+        last_calls = calls;
+    }
+
+private:
+    std::mutex mutex;
+    std::ofstream trace_out;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last_time = start_time;
+    long long last_calls = 0;
+};
+
+Logger logger(LogLevel::QUIET);
+
+//-------------------------------------
+// 0. CharacterSet
+//-------------------------------------
+class CharacterSet {
+private:
+    std::set<char> valid_chars;
+
+public:
+    CharacterSet() {
+        initializeDefault();
+    }
+
+    void initializeDefault() {
+        valid_chars.clear();
+
+        std::vector<char> chars = { ')', '}', ']' };
+
+        for(auto c: chars){
+            valid_chars.insert(c);
+        }
+
+        for (int i = 33; i <= 126; ++i) {
+            char c = static_cast<char>(i);
+            if (std::find(chars.begin(), chars.end(), c) 
+                == chars.end()) 
+            {
+                valid_chars.insert(c);
+            }
+        }
+
+        valid_chars.insert('\n');
+        valid_chars.insert('\t');
+    }
+
+    std::set<char>::iterator begin() { return valid_chars.begin(); }
+    std::set<char>::iterator end() { return valid_chars.end(); }
+};
+
+//-------------------------------------
+// 1. ParseResult enum class
+//-------------------------------------
+enum class ParseResult { INCOMPLETE, CORRECT, INCORRECT };
+
+//-------------------------------------
+// Generate a unique temporary filename and create the file
+// Using mkstemp() ensures there is no conflict with existing files
+//-------------------------------------
+std::string generateTempFile()
+{
+    // "XXXXXX" will be replaced by mkstemp() with a unique string
+    char pattern[] = "/tmp/parser_inputXXXXXX";
+    int fd = mkstemp(pattern);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to create temp file");
+    }
+    // We only create the file here and get the filename, then close the fd
+    close(fd);
+    return std::string(pattern);
+}
+
+//-------------------------------------
+// 2. External parser returning ParseResult
+//    Uses a unique temporary file name to avoid concurrency conflicts.
+//    runParser() touches no shared state, so speculative workers can call
+//    it; the Oracle counts every answer the search uses.
+//-------------------------------------
+// Exit code / callback verdict to ParseResult
+ParseResult verdictOf(int code) {
+    if (code == REPAIR_CORRECT) return ParseResult::CORRECT;
+    if (code == REPAIR_INCOMPLETE) return ParseResult::INCOMPLETE;
+    return ParseResult::INCORRECT;
+}
+
+ParseResult runParser(const std::string& parser_path, const std::string& input) {
+    // Generate a unique temporary file
+    std::string temp_file;
+    try {
+        temp_file = generateTempFile();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return ParseResult::INCORRECT;
+    }
+
+    // Write the input to the temporary file
+    {
+        std::ofstream temp_out(temp_file);
+        if (!temp_out.is_open()) {
+            std::cerr << "Error: Could not create temporary file." << std::endl;
+            return ParseResult::INCORRECT;
+        }
+        temp_out << input;
+    }
+    // Call the external parser
+    // parser_path + " " + temp_file + " > /dev/null 2>&1"
+    std::string command = parser_path + " " + temp_file + " > /dev/null 2>&1";
+    int status = system(command.c_str());
+
+    ParseResult result = ParseResult::INCORRECT;
+    if (WIFEXITED(status)) {
+        result = verdictOf(WEXITSTATUS(status));
+    }
+
+    // Remove the temporary file when done to avoid leftovers
+    std::remove(temp_file.c_str());
+    return result;
+}
+
+std::function<ParseResult(const std::string&)> createParser(const std::string& parser_path) {
+    return [parser_path](const std::string& input) -> ParseResult {
+        return runParser(parser_path, input);
+    };
+}
+
+//-------------------------------------
+// 2.0 PersistentSubjects
+//     Warm subject processes started as "<parser_path> --persistent <n>":
+//     each input goes to the subject's stdin as a 4-byte little-endian
+//     length and the bytes, and the verdict comes back as one byte on its
+//     file descriptor 3 (the same socket).  A process is retired after n
+//     inputs, as the subject then exits by itself.  If it dies during an
+//     input, its exit status is the verdict, as with runParser(); if none
+//     can be started, runParser() answers.  There is one process per
+//     concurrent caller, so speculative workers get their own.
+//     nextBytes() asks for the bytes b with prefix + b not INCORRECT: the
+//     length goes out with its top bit set and a 32-byte bitmap comes back,
+//     then the number of parses the subject ran for it (4 bytes, LE).
+//-------------------------------------
+class PersistentSubjects {
+public:
+    PersistentSubjects(const std::string& parser_path, int recycle)
+        : parser_path(parser_path), command("exec " + parser_path + " --persistent " + std::to_string(recycle)),
+          recycle(recycle) {}
+
+    ~PersistentSubjects() {
+        for (Process& p : idle) retire(p);
+    }
+
+    // Does the subject answer in persistent mode?  (A subject without it
+    // takes "--persistent" for a file name and exits with 2.)
+    // With next_bytes, the next-byte query must be answered as well.
+    bool probe(bool next_bytes) {
+        Process p;
+        unsigned char reply[36];
+        if (!spawn(p)) return false;
+        if (!exchange(p, "", false, reply, 1) || (next_bytes && !exchange(p, "", true, reply, 36))) {
+            retire(p);
+            return false;
+        }
+        release(p);
+        return true;
+    }
+
+    // Throws for inputs of 2^31 bytes or more: their length would carry
+    // the next-byte flag
+    ParseResult operator()(const std::string& input) {
+        if (input.size() >= 0x80000000u) throw std::length_error("input too large for --persistent: 2 GiB or more");
+        Process p;
+        if (!acquire(p)) return runParser(parser_path, input);
+        unsigned char verdict;
+        if (exchange(p, input, false, &verdict, 1)) {
+            release(p);
+            return verdictOf(verdict);
+        }
+        int status = retire(p);
+        return WIFEXITED(status) ? verdictOf(WEXITSTATUS(status)) : ParseResult::INCORRECT;
+    }
+
+    // false if there is no answer (the caller then assumes every byte)
+    bool nextBytes(const std::string& prefix, size_t len, std::bitset<256>& viable, long long& parses) {
+        Process p;
+        unsigned char bitmap[36];
+        if (len >= 0x80000000u || !acquire(p)) return false;
+        if (!exchange(p, prefix.substr(0, len), true, bitmap, 36)) {
+            retire(p);
+            return false;
+        }
+        release(p);
+        viable.reset();
+        for (int b = 0; b < 256; b++) {
+            if (bitmap[b / 8] >> (b % 8) & 1) viable.set(b);
+        }
+        parses = bitmap[32] | bitmap[33] << 8 | bitmap[34] << 16 | static_cast<long long>(bitmap[35]) << 24;
+        return true;
+    }
+
+private:
+    struct Process {
+        pid_t pid = -1;
+        int fd = -1;
+        int served = 0;
+    };
+
+    std::string parser_path;
+    std::string command;
+    int recycle;
+    std::mutex mutex;
+    std::vector<Process> idle;
+
+    bool spawn(Process& p) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return false;
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(sv[0]);
+            close(sv[1]);
+            return false;
+        }
+        if (pid == 0) {
+            // only async-signal-safe calls between fork and exec
+            int null = open("/dev/null", O_RDWR);
+            dup2(sv[1], 0);
+            dup2(sv[1], 3);
+            dup2(null, 1);
+            dup2(null, 2);
+            execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(sv[1]);
+        p.pid = pid;
+        p.fd = sv[0];
+        p.served = 0;
+        return true;
+    }
+
+    // An idle process, or a new one
+    bool acquire(Process& p) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty()) {
+                p = idle.back();
+                idle.pop_back();
+                return true;
+            }
+        }
+        return spawn(p);
+    }
+
+    // Send one input (next: as a next-byte query) and read the n-byte reply
+    static bool exchange(Process& p, const std::string& input, bool next, unsigned char* reply, size_t n) {
+        unsigned char header[4];
+        for (int i = 0; i < 4; i++) header[i] = static_cast<unsigned char>(input.size() >> (8 * i));
+        if (next) header[3] |= 0x80;
+        return sendAll(p.fd, header, 4) && sendAll(p.fd, input.data(), input.size()) && recvAll(p.fd, reply, n);
+    }
+
+    // Back to the idle list after an answer, unless it is used up
+    void release(Process& p) {
+        if (++p.served >= recycle) {
+            retire(p);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(p);
+    }
+
+    // Close the connection and reap the process; returns its wait status
+    static int retire(Process& p) {
+        int status = 0;
+        close(p.fd);
+        while (waitpid(p.pid, &status, 0) < 0 && errno == EINTR) {}
+        p.pid = -1;
+        return status;
+    }
+
+    static bool sendAll(int fd, const void* data, size_t len) {
+        const char* bytes = static_cast<const char*>(data);
+        while (len > 0) {
+            ssize_t n = send(fd, bytes, len, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            bytes += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    static bool recvAll(int fd, unsigned char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = recv(fd, data, len, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+};
+
+
+//-------------------------------------
+// 2.1 PrefixIndex
+//     A radix trie of all answered strings.  For a prefix-monotone subject
+//     (every extension of an INCORRECT string is INCORRECT, and every prefix
+//     of a CORRECT or INCOMPLETE string is not INCORRECT) it also infers
+//     answers: a node is "bad" if its string was INCORRECT and "viable
+//     below" if it or any string underneath was not.  Not every subject is
+//     monotone (tiny rejects "wh" but accepts "while"), so without `infer`
+//     it only returns answers to the same string.  Edge labels only hold the
+//     bytes that were new when the edge was created.
+//-------------------------------------
+class PrefixIndex {
+public:
+    enum class Known { UNKNOWN, BAD, VIABLE };
+
+    struct Answer {
+        Known known = Known::UNKNOWN;
+        const ParseResult* exact = nullptr;   // answer for exactly this string
+    };
+
+    size_t limit_bytes = 256u << 20;          // stop growing beyond this size
+    bool infer = true;                        // the subject is prefix-monotone
+
+    Answer lookup(const std::string& s, size_t len) const {
+        Answer a;
+        const Node* node = &root;
+        size_t i = 0;
+        for (;;) {
+            if (node->bad) { a.known = Known::BAD; return a; }
+            if (i == len) {
+                if (node->viable_below) a.known = Known::VIABLE;
+                if (node->has_result) a.exact = &node->result;
+                return a;
+            }
+            const Node* child = node->find(s[i]);
+            if (!child) return a;
+            size_t k = child->match(s, i, len);
+            if (k == child->length()) { node = child; i += k; continue; }
+            // s ends inside the edge: it is a proper prefix of what lies below
+            if (i + k == len && child->viable_below) a.known = Known::VIABLE;
+            return a;
+        }
+    }
+
+    void insert(const std::string& s, size_t len, ParseResult result) {
+        bool viable = infer && result != ParseResult::INCORRECT;
+        Node* node = &root;
+        size_t i = 0;
+        for (;;) {
+            if (node->bad) return;                   // already implied
+            if (viable) node->viable_below = true;
+            if (i == len) break;
+            Node* child = node->find(s[i]);
+            if (!child) {
+                if (bytes >= limit_bytes) { full++; return; }
+                std::unique_ptr<Node> leaf(new Node);
+                leaf->text = std::make_shared<const std::string>(s, i, len - i);
+                leaf->begin = 0;
+                leaf->end = len - i;
+                bytes += sizeof(Node) + (len - i);
+                nodes++;
+                child = leaf.get();
+                node->children.push_back(std::move(leaf));
+                node = child;
+                i = len;
+                if (viable) node->viable_below = true;
+                break;
+            }
+            size_t k = child->match(s, i, len);
+            if (k < child->length()) {
+                child = node->split(child, k);
+                bytes += sizeof(Node);
+                nodes++;
+            }
+            node = child;
+            i += k;
+        }
+        node->has_result = true;
+        node->result = result;
+        if (infer && !viable) {
+            node->bad = true;
+            node->children.clear();                  // everything below is implied now
+        }
+    }
+
+    size_t nodeCount() const { return nodes; }
+    size_t byteCount() const { return bytes; }
+    long long fullCount() const { return full; }
+
+private:
+    struct Node {
+        std::shared_ptr<const std::string> text;  // edge label: (*text)[begin, end)
+        size_t begin = 0, end = 0;
+        std::vector<std::unique_ptr<Node>> children;
+        bool bad = false;
+        bool viable_below = false;
+        bool has_result = false;
+        ParseResult result = ParseResult::INCORRECT;
+
+        size_t length() const { return end - begin; }
+
+        Node* find(char c) const {
+            for (const auto& child : children)
+                if ((*child->text)[child->begin] == c) return child.get();
+            return nullptr;
+        }
+
+        // Number of label bytes equal to s[i, len)
+        size_t match(const std::string& s, size_t i, size_t len) const {
+            size_t n = std::min(length(), len - i);
+            const char* label = text->data() + begin;
+            size_t k = 0;
+            while (k < n && label[k] == s[i + k]) k++;
+            return k;
+        }
+
+        // Insert a node after the first k bytes of child's label
+        Node* split(Node* child, size_t k) {
+            for (auto& slot : children) {
+                if (slot.get() != child) continue;
+                std::unique_ptr<Node> mid(new Node);
+                mid->text = child->text;
+                mid->begin = child->begin;
+                mid->end = child->begin + k;
+                mid->viable_below = child->viable_below;
+                child->begin += k;
+                mid->children.push_back(std::move(slot));
+                slot = std::move(mid);
+                return slot.get();
+            }
+            return nullptr;
+        }
+    };
+
+    Node root;
+    size_t nodes = 1;
+    size_t bytes = sizeof(Node);
+    long long full = 0;
+};
+
+//-------------------------------------
+// 2.2 Speculator
+//     A pool of workers that runs the parser on strings the search is likely
+//     to ask about next.  request() queues a string, retarget() drops the
+//     queued strings no worker has started (the caller then queues a fresh
+//     window), cancel() also drops finished answers nobody took.  take()
+//     hands out a finished answer, waits for one that is being computed,
+//     and otherwise withdraws the string so the caller runs it itself.
+//     Answers that are computed but never taken are counted as wasted.
+//-------------------------------------
+class Speculator {
+public:
+    long long issued = 0;       // parser runs made by the workers
+    long long useful = 0;       // ... whose answers were taken
+    long long wasted = 0;       // ... whose answers were dropped
+    long long cancelled = 0;    // queued strings dropped by cancel() before they ran
+
+    Speculator(std::function<ParseResult(const std::string&)> run, int workers) : run(std::move(run)) {
+        for (int i = 0; i < workers; i++) threads.emplace_back([this] { work(); });
+    }
+
+    ~Speculator() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            pending.clear();
+            queued.clear();
+        }
+        work_ready.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    void request(const std::string& s) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queued.count(s) || running.count(s) || results.count(s)) return;
+        queued.insert(s);
+        pending.push_back(s);
+        work_ready.notify_one();
+    }
+
+    void retarget() {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.clear();
+        queued.clear();
+    }
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled += queued.size();
+        wasted += results.size();
+        pending.clear();
+        queued.clear();
+        results.clear();
+    }
+
+    bool take(const std::string& s, ParseResult& r) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            auto it = results.find(s);
+            if (it != results.end()) {
+                r = it->second;
+                results.erase(it);
+                useful++;
+                return true;
+            }
+            if (!running.count(s)) break;
+            done.wait(lock);
+        }
+        queued.erase(s);
+        return false;
+    }
+
+    // Count what is left over; call once the search is done
+    void finish() {
+        std::unique_lock<std::mutex> lock(mutex);
+        pending.clear();
+        queued.clear();
+        done.wait(lock, [this] { return running.empty(); });
+        wasted += results.size();
+        results.clear();
+    }
+
+private:
+    std::function<ParseResult(const std::string&)> run;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work_ready, done;
+    std::deque<std::string> pending;                    // may hold strings no longer queued
+    std::unordered_set<std::string> queued;
+    std::unordered_set<std::string> running;
+    std::unordered_map<std::string, ParseResult> results;
+    bool stopping = false;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            work_ready.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) return;
+            std::string s = std::move(pending.front());
+            pending.pop_front();
+            if (!queued.erase(s)) continue;             // withdrawn or retargeted
+            running.insert(s);
+            lock.unlock();
+            ParseResult r = ParseResult::INCORRECT;
+            bool answered = true;
+            try {
+                r = run(s);
+            } catch (const std::exception&) {
+                answered = false;                       // take() fails; the search runs s and gets the error
+            }
+            lock.lock();
+            running.erase(s);
+            if (answered) {
+                issued++;
+                results.emplace(s, r);
+            }
+            done.notify_all();
+        }
+    }
+};
+
+//-------------------------------------
+// 2.3 Prechecks
+//     Cheap in-process necessary conditions, per input format.  A precheck
+//     returns false only if the subject is certain to answer INCORRECT: it
+//     finds an error the subject reaches before the end of the input, and
+//     nothing before it that could stop the subject with another answer.
+//     Anything it is not sure about is left to the subject.
+//-------------------------------------
+typedef bool (*Precheck)(const std::string& s, size_t len);
+
+// JSON (cJSON): a closing bracket that does not match the innermost open
+// one, outside strings.  A NUL byte ends cJSON's input early.
+bool precheckJsonBrackets(const std::string& s, size_t len) {
+    std::string open;
+    bool in_string = false, escaped = false;
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        if (c == '\0') return true;
+        if (in_string) {
+            if (escaped) escaped = false;
+            else if (c == '\\') escaped = true;
+            else if (c == '"') in_string = false;
+            continue;
+        }
+        if (c == '"') {
+            in_string = true;
+        } else if (c == '[' || c == '{') {
+            open.push_back(c);
+        } else if (c == ']' || c == '}') {
+            if (open.empty() || open.back() != (c == ']' ? '[' : '{')) return false;
+            open.pop_back();
+        }
+    }
+    return true;
+}
+
+// S-expressions (sexp-parser): a ')' with no open list, outside strings
+// and escapes.  The reader gives up with INCOMPLETE at a 0xFF byte outside
+// a string (it reads into a char, so that is EOF) and at a string or
+// symbol of 256 bytes; stop looking there.
+bool precheckSexpParens(const std::string& s, size_t len) {
+    size_t depth = 0, token = 0;
+    bool in_string = false, escaped = false;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (in_string) {
+            if (escaped) escaped = false;
+            else if (c == '\\') { escaped = true; continue; }
+            else if (c == '"') { in_string = false; token = 0; continue; }
+            if (++token >= 255) return true;
+            continue;
+        }
+        if (c == 0xFF) return true;
+        if (escaped) {
+            escaped = false;
+            if (++token >= 255) return true;
+            continue;
+        }
+        switch (c) {
+        case '\\': escaped = true; break;
+        case '"':  in_string = true; token = 0; break;
+        case '(':  depth++; token = 0; break;
+        case ')':
+            if (depth == 0) return false;
+            depth--;
+            token = 0;
+            break;
+        case ' ': case '\t': case '\n': case '\r':
+        case '\'': case ',': case ';': case '`':
+            token = 0;
+            break;
+        default:
+            if (++token >= 255) return true;
+        }
+    }
+    return true;
+}
+
+// DOT: a '}' or ']' that does not match the innermost open bracket, or any
+// bracket but ']' inside an attribute list, outside strings and comments.
+// Gives up at '<' (HTML strings nest) and at \" in a string, which the
+// lexer may take as either an escape or the closing quote.
+bool precheckDotBrackets(const std::string& s, size_t len) {
+    std::string open;
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        switch (c) {
+        case '<':
+            return true;
+        case '"':
+            for (i++; i < len && s[i] != '"'; i++) {}
+            if (i < len && s[i - 1] == '\\') return true;
+            break;
+        case '#':
+            while (i < len && s[i] != '\n' && s[i] != '\r') i++;
+            break;
+        case '/':
+            if (i + 1 < len && s[i + 1] == '/') {
+                while (i < len && s[i] != '\n') i++;
+            } else if (i + 1 < len && s[i + 1] == '*') {
+                size_t end = s.find("*/", i + 2);
+                if (end == std::string::npos || end + 2 > len) return true;
+                i = end + 1;
+            }
+            break;
+        case '{': case '[':
+            if (!open.empty() && open.back() == '[') return false;
+            open.push_back(c);
+            break;
+        case '}': case ']':
+            if (open.empty() || open.back() != (c == ']' ? '[' : '{')) return false;
+            open.pop_back();
+            break;
+        }
+    }
+    return true;
+}
+
+// C subset (tiny.c): a byte the lexer has no token for, or a finished word
+// of two or more letters that is not a keyword.  The lexer reaches it
+// unless the parser fails first; a NUL byte ends the input.  Inputs over
+// the subject's 1000-byte buffer are rejected too.
+bool precheckTinyCLexer(const std::string& s, size_t len) {
+    static const char* const keywords[] = { "do", "else", "if", "while" };
+    if (len > 1000) return false;
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+        if (c == '\0') return true;
+        if (c >= 'a' && c <= 'z') {
+            size_t j = i + 1;
+            while (j < len && ((s[j] >= 'a' && s[j] <= 'z') || s[j] == '_')) j++;
+            if (j == len || j - i >= 100) return true;    // may still grow / overflows id_name
+            if (j - i > 1) {
+                bool keyword = false;
+                for (const char* k : keywords)
+                    keyword = keyword || (strlen(k) == j - i && s.compare(i, j - i, k) == 0);
+                if (!keyword) return false;
+            }
+            i = j - 1;
+            continue;
+        }
+        if (c >= '0' && c <= '9') continue;
+        if (!strchr(" \n{}()+-<;=", c)) return false;
+    }
+    return true;
+}
+
+// Prechecks by format; the format defaults to the one of the subject named
+// by the oracle command (as bm_*.py name them).
+std::vector<Precheck> prechecksFor(const std::string& format) {
+    if (format == "json") return { precheckJsonBrackets };
+    if (format == "lisp") return { precheckSexpParens };
+    if (format == "dot")  return { precheckDotBrackets };
+    if (format == "c")    return { precheckTinyCLexer };
+    return {};
+}
+
+// Formats whose subjects are known to be prefix-monotone: no prefix of a
+// valid file is INCORRECT.  tiny ("c") is not: "wh" is INCORRECT.  Nor is
+// cjson: "[-" is INCORRECT, "[-1]" CORRECT.
+bool monotoneFormat(const std::string& format) {
+    return format == "lisp";
+}
+
+std::string formatOfSubject(const std::string& parser_path) {
+    std::string command = parser_path.substr(0, parser_path.find(' '));
+    std::string name = command.substr(command.rfind('/') + 1);
+    if (name == "cjson") return "json";
+    if (name == "sexp") return "lisp";
+    if (name == "dot_parser" || name == "dot_fast") return "dot";
+    if (name == "tiny") return "c";
+    return "";
+}
+
+//-------------------------------------
+// 2.4 Shadow
+//     Differential check of the fast paths: a sample of the answers that
+//     did not come from the reference subject (prechecks, prefix-index
+//     inferences, and the parser itself when it is a callback or another
+//     command) is re-run against the reference with runParser() on a
+//     background worker.  A disagreement is counted and logged with the
+//     input.  Answers that only claim "not INCORRECT" (viable inferences)
+//     are compared as such.  When the queue is full a sample is dropped,
+//     so the search never waits for the reference.
+//-------------------------------------
+class Shadow {
+public:
+    std::atomic<long long> sampled{0};      // answers queued for a re-check
+    std::atomic<long long> dropped{0};      // ... not queued, the queue was full
+    std::atomic<long long> checked{0};      // re-checked against the reference
+    std::atomic<long long> mismatches{0};
+
+    Shadow(const std::string& reference, double rate, const std::string& log_path)
+        : reference(reference), rate(std::min(std::max(rate, 0.0), 1.0)), rng(0x5eed) {
+        if (!log_path.empty()) {
+            log_out.open(log_path, std::ios::app);
+            if (!log_out.is_open()) throw std::runtime_error("cannot open shadow log " + log_path);
+        }
+        worker = std::thread([this] { work(); });
+    }
+
+    ~Shadow() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            pending.clear();
+        }
+        work_ready.notify_all();
+        worker.join();
+    }
+
+    // The fast path answered s[0, len) with r (viable_only: only "not INCORRECT")
+    void sample(const char* source, const std::string& s, size_t len, ParseResult r, bool viable_only) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!coin(rng)) return;
+        if (pending.size() >= MAX_PENDING) {
+            dropped++;
+            return;
+        }
+        sampled++;
+        pending.push_back(Check{ source, s.substr(0, len), r, viable_only });
+        work_ready.notify_one();
+    }
+
+    // Wait until every queued check is done
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending.empty() && !busy; });
+    }
+
+    const std::string& referenceCommand() const { return reference; }
+
+private:
+    static const size_t MAX_PENDING = 4096;
+
+    struct Check {
+        const char* source;
+        std::string input;
+        ParseResult answer;
+        bool viable_only;
+    };
+
+    std::string reference;
+    double rate;
+    std::mt19937 rng;
+    std::bernoulli_distribution coin{rate};
+    std::ofstream log_out;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable work_ready, done;
+    std::deque<Check> pending;
+    bool busy = false;
+    bool stopping = false;
+
+    static const char* name(ParseResult r) {
+        return r == ParseResult::CORRECT ? "CORRECT" : r == ParseResult::INCOMPLETE ? "INCOMPLETE" : "INCORRECT";
+    }
+
+    // One line per input: C-style escapes for quotes, backslashes and non-printables
+    static std::string escaped(const std::string& s) {
+        std::string out;
+        for (unsigned char c : s) {
+            if (c == '\n') out += "\\n";
+            else if (c == '\t') out += "\\t";
+            else if (c == '"' || c == '\\') { out += '\\'; out += static_cast<char>(c); }
+            else if (c < 32 || c > 126) {
+                char hex[5];
+                snprintf(hex, sizeof hex, "\\x%02x", c);
+                out += hex;
+            } else out += static_cast<char>(c);
+        }
+        return out;
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            work_ready.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) return;
+            Check c = std::move(pending.front());
+            pending.pop_front();
+            busy = true;
+            lock.unlock();
+            ParseResult truth = runParser(reference, c.input);
+            bool agree = c.viable_only ? (truth != ParseResult::INCORRECT) == (c.answer != ParseResult::INCORRECT)
+                                       : truth == c.answer;
+            std::string line;
+            if (!agree) {
+                line = std::string(c.source) + ": " + (c.viable_only ? "viable" : name(c.answer))
+                       + ", reference: " + name(truth) + ", input (" + std::to_string(c.input.size())
+                       + " bytes): \"" + escaped(c.input) + "\"";
+            }
+            lock.lock();
+            busy = false;
+            checked++;
+            if (!agree) {
+                mismatches++;
+                if (log_out.is_open()) {
+                    log_out << line << std::endl;
+                } else {
+                    logger.log(LogLevel::INFO, "shadow mismatch, " + line);
+                }
+            }
+            done.notify_all();
+        }
+    }
+};
+
+//-------------------------------------
+// 2.5 Oracle
+//     The parser plus the prefix index: exact answers for the CORRECT
+//     checks, viable() (not INCORRECT) for the boundary search.  Unless the
+//     subject is monotone the index only answers repeated questions.  With a
+//     Speculator, answers computed ahead of time are used in place of a
+//     parser run and counted as one.  Strings a precheck rejects are
+//     INCORRECT without asking the parser.  Past its deadline the oracle
+//     throws DeadlineExceeded instead of running the parser.  With a
+//     Shadow, a sample of the answers from prechecks, inferences and (if it
+//     is not the reference) the parser is re-checked in the background.
+//     With a next-byte oracle, viableNext() names the bytes that may follow
+//     a prefix; the search skips the others without asking the parser.  The
+//     parses a subject ran to answer it are counted in next_parses.
+//     With a region scan (the regex formats), regionBoundary() gives the
+//     longest viable prefix in place of a binary search, and accepts() does
+//     not ask about strings whose prefix or suffix the scan found dead.
+//-------------------------------------
+// (prefix, its length, viable bytes out, parses the answer took out)
+typedef std::function<bool(const std::string&, size_t, std::bitset<256>&, long long&)> NextBytes;
+typedef std::function<RegexRegion(const std::string&)> RegionScan;
+
+struct DeadlineExceeded : std::runtime_error {
+    DeadlineExceeded() : std::runtime_error("deadline exceeded") {}
+};
+
+class Oracle {
+public:
+    long long inferred_bad = 0;       // INCORRECT because a prefix was
+    long long inferred_viable = 0;    // not INCORRECT because an extension was not
+    long long cached = 0;             // same string asked before
+    long long prechecked = 0;         // rejected by a precheck
+    long long next_queries = 0;       // next-byte oracle answers
+    long long next_skipped = 0;       // candidates they ruled out
+    long long next_parses = 0;        // parses the subject ran for them
+    long long region_scans = 0;       // region scans used
+    long long region_skipped = 0;     // full checks they answered
+    long long runs = 0;               // parser answers used, by verdict:
+    long long correct = 0;
+    long long incorrect = 0;
+    long long incomplete = 0;
+
+    Oracle(std::function<ParseResult(const std::string&)> parser, bool use_index, bool monotone)
+        : parser(std::move(parser)), use_index(use_index) {
+        index.infer = monotone;
+    }
+
+    ParseResult operator()(const std::string& s) {
+        if (use_index) {
+            PrefixIndex::Answer a = index.lookup(s, s.size());
+            if (a.exact) { cached++; return *a.exact; }
+            if (a.known == PrefixIndex::Known::BAD) {
+                inferred_bad++;
+                return shadowed("prefix index", s, s.size(), ParseResult::INCORRECT);
+            }
+        }
+        ParseResult r = rejected(s, s.size()) ? ParseResult::INCORRECT : ask(s);
+        if (use_index) index.insert(s, s.size(), r);
+        return r;
+    }
+
+    // Is the prefix s[0, len) not INCORRECT?
+    bool viable(const std::string& s, size_t len) {
+        if (use_index) {
+            PrefixIndex::Answer a = index.lookup(s, len);
+            if (a.exact) { cached++; return *a.exact != ParseResult::INCORRECT; }
+            if (a.known == PrefixIndex::Known::BAD) {
+                inferred_bad++;
+                shadowed("prefix index", s, len, ParseResult::INCORRECT);
+                return false;
+            }
+            if (a.known == PrefixIndex::Known::VIABLE) {
+                inferred_viable++;
+                if (shadow) shadow->sample("prefix index", s, len, ParseResult::INCOMPLETE, true);
+                return true;
+            }
+        }
+        if (rejected(s, len)) {
+            if (use_index) index.insert(s, len, ParseResult::INCORRECT);
+            return false;
+        }
+        std::string prefix = s.substr(0, len);
+        ParseResult r = ask(prefix);
+        if (use_index) index.insert(prefix, len, r);
+        return r != ParseResult::INCORRECT;
+    }
+
+    void speculate(Speculator* s) { speculator = s; }
+    bool speculating() const { return speculator != nullptr; }
+
+    // Queue s for a worker unless its answer is already known
+    void prefetch(const std::string& s) {
+        if (!speculator) return;
+        if (use_index) {
+            PrefixIndex::Answer a = index.lookup(s, s.size());
+            if (a.exact || a.known == PrefixIndex::Known::BAD) return;
+        }
+        for (Precheck check : prechecks)
+            if (!check(s, s.size())) return;
+        speculator->request(s);
+    }
+
+    void addPrecheck(Precheck check) { prechecks.push_back(check); }
+
+    void nextBytesWith(NextBytes f) { next = std::move(f); }
+    bool hasNextBytes() const { return static_cast<bool>(next); }
+
+    // Bytes b for which s[0, len) + b may be viable (all without an answer)
+    std::bitset<256> viableNext(const std::string& s, size_t len) {
+        std::bitset<256> viable;
+        if (has_deadline && std::chrono::steady_clock::now() >= deadline) throw DeadlineExceeded();
+        long long parses = 0;
+        if (next && next(s, len, viable, parses)) {
+            next_queries++;
+            next_parses += parses;
+        } else {
+            viable.set();
+        }
+        return viable;
+    }
+
+    // A candidate ruled out by viableNext(); its prefix s[0, len) is INCORRECT
+    void skipped(const std::string& s, size_t len) {
+        next_skipped++;
+        shadowed("next bytes", s, len, ParseResult::INCORRECT);
+    }
+
+    void regionWith(RegionScan f) { region = std::move(f); }
+
+    // Longest viable prefix of s from the region scan, if there is one.  The
+    // first dead prefix goes into the index.
+    bool regionBoundary(const std::string& s, size_t& boundary) {
+        if (!region) return false;
+        RegexRegion r = region(s);
+        region_scans++;
+        if (shadow) shadow->sample("region", s, r.prefix, ParseResult::INCOMPLETE, true);
+        if (r.prefix < s.size()) {
+            shadowed("region", s, r.prefix + 1, ParseResult::INCORRECT);
+            if (use_index) index.insert(s, r.prefix + 1, ParseResult::INCORRECT);
+        }
+        boundary = r.prefix;
+        return true;
+    }
+
+    // Is s CORRECT?  Not if the region scan finds a dead prefix or suffix
+    bool accepts(const std::string& s) {
+        if (region) {
+            RegexRegion r = region(s);
+            region_scans++;
+            if (r.prefix < s.size() || r.suffix > 0) {
+                region_skipped++;
+                if (r.prefix < s.size()) shadowed("region", s, s.size(), ParseResult::INCORRECT);
+                return false;
+            }
+        }
+        return (*this)(s) == ParseResult::CORRECT;
+    }
+
+    // parser_too: the parser is a fast path as well (not the reference)
+    void shadowWith(Shadow* s, bool parser_too) {
+        shadow = s;
+        shadow_parser = parser_too;
+    }
+
+    void setDeadline(std::chrono::steady_clock::time_point when) {
+        deadline = when;
+        has_deadline = true;
+    }
+
+    void retargetSpeculation() { if (speculator) speculator->retarget(); }
+    void cancelSpeculation() { if (speculator) speculator->cancel(); }
+
+    const PrefixIndex& prefixIndex() const { return index; }
+    bool indexed() const { return use_index; }
+    bool monotone() const { return index.infer; }
+
+private:
+    std::function<ParseResult(const std::string&)> parser;
+    bool use_index;
+    PrefixIndex index;
+    Speculator* speculator = nullptr;
+    std::vector<Precheck> prechecks;
+    Shadow* shadow = nullptr;
+    bool shadow_parser = false;
+    NextBytes next;
+    RegionScan region;
+    bool has_deadline = false;
+    std::chrono::steady_clock::time_point deadline;
+
+    bool rejected(const std::string& s, size_t len) {
+        for (Precheck check : prechecks) {
+            if (!check(s, len)) {
+                prechecked++;
+                shadowed("precheck", s, len, ParseResult::INCORRECT);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ParseResult shadowed(const char* source, const std::string& s, size_t len, ParseResult r) {
+        if (shadow) shadow->sample(source, s, len, r, false);
+        return r;
+    }
+
+    ParseResult ask(const std::string& s) {
+        if (has_deadline && std::chrono::steady_clock::now() >= deadline) throw DeadlineExceeded();
+        ParseResult r;
+        if (!speculator || !speculator->take(s, r)) r = parser(s);
+        if (shadow_parser) shadowed("parser", s, s.size(), r);
+        runs++;
+        if (r == ParseResult::CORRECT) {
+            correct++;
+        } else if (r == ParseResult::INCOMPLETE) {
+            incomplete++;
+        } else {
+            incorrect++;
+        }
+        return r;
+    }
+};
+
+//-------------------------------------
+// 3. BSearch function
+//-------------------------------------
+int BSearch(const std::string& s,
+            Oracle& parser,
+            int left = 0) {
+    size_t scanned;
+    if (parser.regionBoundary(s, scanned)) return std::max(left, static_cast<int>(scanned));
+
+    int right = static_cast<int>(s.size());
+    // If the entire string is not INCORRECT, return directly
+    if (parser.viable(s, right)) return right;
+
+    // Binary search for boundary
+    while (left < right - 1) {
+        int middle = (left + right) / 2;
+        if (parser.viable(s, middle)) {
+            left = middle;
+        } else {
+            right = middle;
+        }
+    }
+
+    return left;
+}
+
+//-------------------------------------
+// 3.0 SpillFile
+//     Append-only scratch file, memory-mapped, for frontier states that do
+//     not fit in memory.  The file is unlinked right away, grows by doubling
+//     and is rewound once nothing in it is live.
+//-------------------------------------
+class SpillFile {
+public:
+    ~SpillFile() {
+        if (map) munmap(map, capacity);
+        if (fd >= 0) close(fd);
+    }
+
+    // Offset of the copied bytes
+    size_t append(const void* data, size_t n) {
+        if (used + n > capacity) grow(used + n);
+        memcpy(map + used, data, n);
+        size_t offset = used;
+        used += n;
+        return offset;
+    }
+
+    const char* at(size_t offset) const { return map + offset; }
+    void rewind() { used = 0; }
+    size_t size() const { return used; }
+
+private:
+    int fd = -1;
+    char* map = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+
+    void grow(size_t needed) {
+        if (fd < 0) {
+            char pattern[] = "/tmp/erepair_frontierXXXXXX";
+            fd = mkstemp(pattern);
+            if (fd == -1) throw std::runtime_error("Failed to create frontier spill file");
+            unlink(pattern);
+        }
+        size_t new_capacity = capacity ? capacity : (64u << 20);
+        while (new_capacity < needed) new_capacity *= 2;
+        if (ftruncate(fd, static_cast<off_t>(new_capacity)) != 0)
+            throw std::runtime_error("Failed to grow frontier spill file");
+        if (map) munmap(map, capacity);
+        void* m = mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) throw std::runtime_error("Failed to map frontier spill file");
+        map = static_cast<char*>(m);
+        capacity = new_capacity;
+    }
+};
+
+//-------------------------------------
+// 3.1 BucketQueue
+//     DRepair's frontier.  Edit distances are small integers, so states are
+//     kept in one bucket per distance and the lowest non-empty bucket is
+//     served first.  Inside a bucket states leave in FIFO order or, with
+//     BucketOrder::BOUNDARY, furthest boundary first and, on equal
+//     boundaries, in the order they were pushed.  push() numbers each state
+//     in State::sequence for that.  clear() keeps the buckets' storage for
+//     the next round.
+//     With a memory limit, the highest-distance buckets are written to a
+//     SpillFile once the queued strings exceed it, and read back when the
+//     search reaches them; the order of the search does not change.
+//-------------------------------------
+enum class BucketOrder { FIFO, BOUNDARY };
+
+template <typename State>
+class BucketQueue {
+public:
+    explicit BucketQueue(BucketOrder order = BucketOrder::FIFO, size_t memory_limit = 0)
+        : order(order), memory_limit(memory_limit) {}
+
+    ~BucketQueue() {
+        if (spilled) {
+            logger.log(LogLevel::DEBUG, "frontier spilled " + std::to_string(spilled) + " states, reloaded "
+                       + std::to_string(reloaded) + ", peak " + std::to_string(peak_bytes >> 10) + " KiB in memory");
+        }
+    }
+
+    long long spilled = 0;           // states written to the spill file
+    long long reloaded = 0;          // states read back
+    size_t peak_bytes = 0;
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    size_t bytes() const { return memory; }
+
+    void push(State state) {
+        int distance = state.editingDistance;
+        if (buckets.empty()) {
+            lowest = distance;
+            buckets.emplace_back();
+        }
+        // The "all accepted" step may push below the current minimum
+        while (distance < lowest) {
+            buckets.emplace_front();
+            lowest--;
+            cursor++;
+        }
+        size_t i = static_cast<size_t>(distance - lowest);
+        if (i >= buckets.size()) buckets.resize(i + 1);
+        Bucket& bucket = buckets[i];
+        state.sequence = next_sequence++;
+        memory += footprint(state);
+        bucket.items.push_back(std::move(state));
+        if (order == BucketOrder::BOUNDARY)
+            std::push_heap(bucket.items.begin(), bucket.items.end(), closerBoundary);
+        if (i < cursor) cursor = i;
+        count++;
+        if (memory > peak_bytes) peak_bytes = memory;
+        if (memory_limit && memory > memory_limit) spill();
+    }
+
+    // Visit up to k of the states pop() returns next, in that order.  The walk
+    // stops at spilled states; with BucketOrder::BOUNDARY only the first
+    // state of a bucket is certain to come first.
+    template <typename Visit>
+    void peek(size_t k, Visit visit) const {
+        for (size_t i = cursor; i < buckets.size() && k > 0; i++) {
+            const Bucket& bucket = buckets[i];
+            if (!bucket.segments.empty()) return;
+            for (size_t j = bucket.head; j < bucket.items.size() && k > 0; j++, k--) visit(bucket.items[j]);
+        }
+    }
+
+    // Remove and return the next state; the queue must not be empty
+    State pop() {
+        while (buckets[cursor].head == buckets[cursor].items.size() && buckets[cursor].segments.empty()) cursor++;
+        Bucket& bucket = buckets[cursor];
+        if (!bucket.segments.empty()) reload(bucket);
+        State state;
+        if (order == BucketOrder::FIFO) {
+            state = std::move(bucket.items[bucket.head++]);
+            if (bucket.head == bucket.items.size()) {
+                bucket.items.clear();
+                bucket.head = 0;
+            }
+        } else {
+            std::pop_heap(bucket.items.begin(), bucket.items.end(), closerBoundary);
+            state = std::move(bucket.items.back());
+            bucket.items.pop_back();
+        }
+        memory -= footprint(state);
+        count--;
+        return state;
+    }
+
+    void clear() {
+        for (size_t i = cursor; i < buckets.size(); i++) {
+            buckets[i].items.clear();
+            buckets[i].head = 0;
+            buckets[i].segments.clear();
+        }
+        cursor = 0;
+        count = 0;
+        memory = 0;
+        live_segments = 0;
+        file.rewind();
+    }
+
+private:
+    struct Segment {
+        size_t offset, length, states;
+    };
+
+    struct Bucket {
+        std::vector<State> items;
+        size_t head = 0;             // FIFO: next item to leave
+        std::vector<Segment> segments;   // spilled states, oldest first
+    };
+
+    struct Record {
+        int boundary;
+        int editingDistance;
+        unsigned long long sequence;
+        size_t length;
+    };
+
+    // Heap order: furthest boundary on top, the earliest pushed among equals.
+    // The order is total, so a bucket rebuilt by reload() leaves in the same order.
+    static bool closerBoundary(const State& a, const State& b) {
+        if (a.boundary != b.boundary) return a.boundary < b.boundary;
+        return a.sequence > b.sequence;
+    }
+    static size_t footprint(const State& s) { return sizeof(State) + s.str.capacity(); }
+
+    // Move the highest-distance buckets (never the one being served) to the
+    // spill file until the queue is back under three quarters of the limit.
+    void spill() {
+        for (size_t i = buckets.size(); i-- > cursor + 1 && memory > memory_limit / 4 * 3; ) {
+            Bucket& bucket = buckets[i];
+            if (bucket.head == bucket.items.size()) continue;
+            Segment segment = {file.size(), 0, 0};
+            for (size_t k = bucket.head; k < bucket.items.size(); k++) {
+                State& state = bucket.items[k];
+                Record record = {state.boundary, state.editingDistance, state.sequence, state.str.size()};
+                file.append(&record, sizeof(record));
+                file.append(state.str.data(), state.str.size());
+                memory -= footprint(state);
+                segment.states++;
+            }
+            segment.length = file.size() - segment.offset;
+            bucket.segments.push_back(segment);
+            live_segments++;
+            spilled += segment.states;
+            bucket.items.clear();
+            bucket.items.shrink_to_fit();
+            bucket.head = 0;
+        }
+    }
+
+    // Bring a bucket's spilled states back in front of its in-memory ones
+    void reload(Bucket& bucket) {
+        std::vector<State> items;
+        for (const Segment& segment : bucket.segments) {
+            const char* p = file.at(segment.offset);
+            for (size_t k = 0; k < segment.states; k++) {
+                Record record;
+                memcpy(&record, p, sizeof(record));
+                p += sizeof(record);
+                State state;
+                state.str.assign(p, record.length);
+                state.boundary = record.boundary;
+                state.editingDistance = record.editingDistance;
+                state.sequence = record.sequence;
+                p += record.length;
+                memory += footprint(state);
+                items.push_back(std::move(state));
+            }
+            reloaded += segment.states;
+        }
+        live_segments -= bucket.segments.size();
+        bucket.segments.clear();
+        if (live_segments == 0) file.rewind();
+        for (size_t k = bucket.head; k < bucket.items.size(); k++) items.push_back(std::move(bucket.items[k]));
+        bucket.items.swap(items);
+        bucket.head = 0;
+        if (order == BucketOrder::BOUNDARY)
+            std::make_heap(bucket.items.begin(), bucket.items.end(), closerBoundary);
+    }
+
+    BucketOrder order;
+    size_t memory_limit;             // bytes of queued states, 0 = no limit
+    std::deque<Bucket> buckets;      // buckets[i] holds distance lowest + i
+    int lowest = 0;
+    size_t cursor = 0;               // no non-empty bucket below this one
+    size_t count = 0;
+    size_t memory = 0;               // footprint of the in-memory states
+    size_t live_segments = 0;
+    unsigned long long next_sequence = 0;
+    SpillFile file;
+};
+
+//-------------------------------------
+// 4. DRepair function
+//-------------------------------------
+std::string DRepair(const std::string& input,
+                    Oracle& parser,
+                    BucketOrder order = BucketOrder::FIFO,
+                    bool substitute = true,
+                    size_t memory_limit = 0,
+                    size_t speculate = 0,
+                    const std::atomic<int>* bound = nullptr) {
+    struct State {
+        std::string str;        // current string
+        int boundary;           // current boundary
+        int editingDistance;    // accumulated editing distance (lower is higher priority)
+        unsigned long long sequence = 0;   // set by the queue on push
+    };
+
+    // Bucket queue, with smaller editingDistance having higher priority
+    BucketQueue<State> pq(order, memory_limit);
+
+    // Initial boundary
+    int boundary = BSearch(input, parser, 0);
+    pq.push({input, boundary, 0});
+
+    CharacterSet valid_chars;
+    long long states = 0;
+
+    // In a portfolio: give up on states with d edits once the best repair
+    // so far is within the edit distance they are expected to reach.  This
+    // is a heuristic, not a bound.  Without substitution a substitution
+    // costs two edits, so d is halved.  A healed insertion that a later
+    // deletion undoes still counts both, so a pruned state can, rarely,
+    // lead to a closer repair.
+    auto beaten = [bound, substitute](int d) {
+        return bound && (substitute ? d : (d + 1) / 2) >= bound->load();
+    };
+
+    // The first question each operator asks about a state is the full check
+    // of the edited string (BSearch's first probe is the same string).  With
+    // a Speculator these are queued for the popped state and the next
+    // `speculate` states of the frontier, in the order they will be asked.
+    auto prefetch = [&](const State& state) {
+        std::string t = state.str;
+        size_t b = static_cast<size_t>(state.boundary);
+        if (b < t.size()) {
+            char original = t[b];
+            t.erase(b, 1);
+            parser.prefetch(t);
+            t.insert(b, 1, original);
+            if (substitute) {
+                for (char c : valid_chars) {
+                    if (c == original) continue;
+                    t[b] = c;
+                    parser.prefetch(t);
+                }
+                t[b] = original;
+            }
+        }
+        for (char c : valid_chars) {
+            t.insert(b, 1, c);
+            parser.prefetch(t);
+            t.erase(b, 1);
+        }
+    };
+
+    while (!pq.empty()) {
+        State current = pq.pop();
+        states++;
+        if (beaten(current.editingDistance)) return "";
+        logger.progress(states, pq.size(), current.boundary, current.str.size(), current.editingDistance, parser.runs);
+        if (parser.speculating()) {
+            parser.retargetSpeculation();
+            prefetch(current);
+            pq.peek(speculate, prefetch);
+        }
+        logger.trace("Dealing with current string", current.str);
+        if (logger.enabled(LogLevel::TRACE)) {
+            logger.log(LogLevel::TRACE, "state " + std::to_string(states) + ": boundary " + std::to_string(current.boundary)
+                       + " length " + std::to_string(current.str.size()) + " distance " + std::to_string(current.editingDistance));
+        }
+        // If the entire string is CORRECT, return directly
+        if (parser.accepts(current.str)) {
+            return current.str;
+        }
+
+        // Substitutions and insertions put one byte after the boundary
+        // prefix; a byte that cannot follow it leaves the boundary where it
+        // is and is skipped.  Unless the subject is prefix-monotone, a
+        // longer string may still be CORRECT, so the edited string is
+        // checked in full and only its boundary search is skipped
+        std::bitset<256> allowed;
+        if (parser.hasNextBytes()) {
+            allowed = parser.viableNext(current.str, current.boundary);
+        } else {
+            allowed.set();
+        }
+
+        if (beaten(current.editingDistance + 1)) return "";
+
+        // 1) Try deleting the character at the boundary
+        if (current.boundary < static_cast<int>(current.str.size())) {
+            std::string new_str = current.str;
+            new_str.erase(current.boundary, 1);
+            if (parser.accepts(new_str)) {
+                return new_str;
+            }
+            int new_boundary = BSearch(new_str, parser);
+
+            if(new_boundary - current.boundary > 0){
+                // Believe this corruption has been healed, handling next corruption
+                logger.log(LogLevel::DEBUG, "deletion at " + std::to_string(current.boundary) + " healed, boundary now " + std::to_string(new_boundary));
+                pq.clear();
+                parser.cancelSpeculation();
+                pq.push({new_str, new_boundary, current.editingDistance + 1});
+                continue;
+            }
+            pq.push({new_str, new_boundary, current.editingDistance + 1});
+        }
+
+        // 2) Try substituting the character at the boundary (one edit, not
+        //    a deletion plus an insertion)
+        if (substitute && current.boundary < static_cast<int>(current.str.size())) {
+            bool healed = false;
+            for (char c : valid_chars) {
+                if (c == current.str[current.boundary]) continue;
+                if (beaten(current.editingDistance + 1)) return "";
+                std::string new_str = current.str;
+                new_str[current.boundary] = c;
+                if (!allowed[static_cast<unsigned char>(c)]) {
+                    if (!parser.monotone() && parser.accepts(new_str)) {
+                        return new_str;
+                    }
+                    parser.skipped(new_str, current.boundary + 1);
+                    continue;
+                }
+
+                if (parser.accepts(new_str)) {
+                    return new_str;
+                }
+                int new_boundary = BSearch(new_str, parser);
+                if (new_boundary - current.boundary > 1) {
+                    // Believe this corruption has been healed, handling next corruption
+                    logger.log(LogLevel::DEBUG, "substitution at " + std::to_string(current.boundary) + " healed, boundary now " + std::to_string(new_boundary));
+                    pq.clear();
+                    parser.cancelSpeculation();
+                    pq.push({new_str, new_boundary, current.editingDistance + 1});
+                    healed = true;
+                    break;
+                } else if (new_boundary - current.boundary == 1) {
+                    pq.push({new_str, new_boundary, current.editingDistance + 1});
+                }
+            }
+            if (healed) continue;
+        }
+
+        // 3) Try inserting various valid characters at the boundary
+        bool flag = false;
+        bool all_accepted = true;
+        for (char c : valid_chars) {
+            if (beaten(current.editingDistance + 1)) return "";
+            std::string new_str = current.str;
+            new_str.insert(current.boundary, 1, c);
+            if (!allowed[static_cast<unsigned char>(c)]) {
+                if (!parser.monotone() && parser.accepts(new_str)) {
+                    return new_str;
+                }
+                parser.skipped(new_str, current.boundary + 1);
+                all_accepted = false;
+                continue;
+            }
+
+            if (parser.accepts(new_str)) {
+                return new_str;
+            }
+            int new_boundary = BSearch(new_str, parser);
+            if (new_boundary - current.boundary > 1) {
+                // Believe this corruption has been healed, handling next corruption 
+                logger.log(LogLevel::DEBUG, "insertion at " + std::to_string(current.boundary) + " healed, boundary now " + std::to_string(new_boundary));
+                pq.clear();
+                parser.cancelSpeculation();
+                pq.push({new_str, new_boundary, current.editingDistance + 1});
+                break;
+            } else if (new_boundary - current.boundary == 1) {
+                pq.push({new_str, new_boundary, current.editingDistance + 1});
+                if(c!='\n' && c!='\t'){
+                    flag = true;
+                }
+            } else {
+                all_accepted = false;
+                continue;
+            }
+        }
+        if (!flag) {
+            if (parser.accepts(current.str.substr(0, current.boundary))) {
+                return current.str.substr(0, current.boundary);
+            }
+        }
+        if (all_accepted && current.boundary == static_cast<int>(current.str.size())) {
+            logger.log(LogLevel::DEBUG, "All accepted at boundary " + std::to_string(current.boundary));
+            std::string temp  = current.str;
+            for(int i=33;i<=126;i++){
+                char c = static_cast<char>(i);
+                temp.push_back(c);
+            }
+            temp.push_back('a'); //watchman
+            int temp_boundary = BSearch(temp, parser);
+            if(temp_boundary!=static_cast<int>(temp.size())-1){
+
+                char c = temp[temp_boundary-1];
+                // std::cout<<"c: "<<c<<std::endl;
+                // std::cout<<temp<<std::endl;
+                current.str.push_back(c);
+                int new_boundary = BSearch(current.str, parser);
+                pq.push({current.str, new_boundary, current.editingDistance-1}); // priority is not increased
+                // pq.clear();
+                // pq.push({current.str, new_boundary, current.editingDistance + 1});
+            } 
+        }
+    }
+
+    // No feasible solution found
+    return "";
+}
+
+//-------------------------------------
+// 4.1 SpanRepair function
+//     Greedy span deletion for inputs with a long run of garbage: at the
+//     boundary, delete the shortest span after which the boundary moves,
+//     and repeat.  Not minimal, and it gives up where an insertion is
+//     needed, but it costs a boundary search per span length rather than a
+//     frontier per deleted byte.
+//-------------------------------------
+std::string SpanRepair(const std::string& input,
+                       Oracle& parser,
+                       const std::atomic<int>* bound = nullptr) {
+    std::string s = input;
+    int deleted = 0;
+    int boundary = BSearch(s, parser);
+    while (!parser.accepts(s)) {
+        // A viable prefix that is not complete needs more than deletions
+        if (boundary >= static_cast<int>(s.size())) return "";
+        bool moved = false;
+        for (size_t span = 1; boundary + span <= s.size(); span++) {
+            if (bound && deleted + static_cast<int>(span) >= bound->load()) return "";
+            std::string t = s;
+            t.erase(boundary, span);
+            int b = BSearch(t, parser, boundary);
+            if (b > boundary || b == static_cast<int>(t.size())) {
+                s.swap(t);
+                boundary = b;
+                deleted += static_cast<int>(span);
+                moved = true;
+                break;
+            }
+        }
+        if (!moved) return "";
+    }
+    return s;
+}
+
+//-------------------------------------
+// 4.2 Portfolio
+//     Strategies race on their own threads, each with its own Oracle (and
+//     prefix index) over one SharedVerdicts, so a string one of them had
+//     run is not run again for another.  The repair with the lowest edit
+//     distance from the input wins, the first found on a tie.  Span
+//     deletion stops once its deletions reach the best distance so far,
+//     which it can no longer beat.  DRepair stops when its frontier reaches
+//     that distance in edits.  Its edits only estimate the distance of the
+//     repairs below (see beaten() there), so that cut-off is a heuristic.
+//-------------------------------------
+class SharedVerdicts {
+public:
+    long long runs = 0;               // parser runs, by verdict:
+    long long correct = 0;
+    long long incorrect = 0;
+    long long incomplete = 0;
+    long long hits = 0;               // answers reused
+
+    explicit SharedVerdicts(std::function<ParseResult(const std::string&)> parser) : parser(std::move(parser)) {}
+
+    // A string another strategy is running now is waited for, not run twice
+    ParseResult operator()(const std::string& s) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = verdicts.find(s);
+        if (it != verdicts.end()) {
+            hits++;
+            std::shared_future<ParseResult> answer = it->second;
+            lock.unlock();
+            return answer.get();
+        }
+        std::promise<ParseResult> promise;
+        verdicts.emplace(s, promise.get_future().share());
+        lock.unlock();
+
+        ParseResult r;
+        try {
+            r = parser(s);
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        promise.set_value(r);
+        lock.lock();
+        runs++;
+        if (r == ParseResult::CORRECT) {
+            correct++;
+        } else if (r == ParseResult::INCOMPLETE) {
+            incomplete++;
+        } else {
+            incorrect++;
+        }
+        return r;
+    }
+
+private:
+    std::function<ParseResult(const std::string&)> parser;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_future<ParseResult>> verdicts;
+};
+
+struct Strategy {
+    const char* name;
+    std::function<std::string(const std::string&, Oracle&, const std::atomic<int>*)> run;
+};
+
+// Levenshtein distance, two rows
+size_t editDistance(const std::string& a, const std::string& b) {
+    std::vector<size_t> previous(b.size() + 1), row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) previous[j] = j;
+    for (size_t i = 1; i <= a.size(); i++) {
+        row[0] = i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            row[j] = std::min({ previous[j] + 1, row[j - 1] + 1, previous[j - 1] + (a[i - 1] != b[j - 1]) });
+        }
+        previous.swap(row);
+    }
+    return previous[b.size()];
+}
+
+// Race strategies[i] with oracles[i]; the winner's name goes to *winner.
+// Throws DeadlineExceeded (or the first error) if no strategy found a
+// repair and one of them ran out of time (or failed).
+std::string Portfolio(const std::string& input,
+                      const std::vector<Strategy>& strategies,
+                      const std::vector<std::unique_ptr<Oracle>>& oracles,
+                      const char** winner) {
+    std::atomic<int> bound(std::numeric_limits<int>::max());
+    std::mutex mutex;
+    std::string best, error;
+    size_t best_distance = std::numeric_limits<size_t>::max();
+    bool expired = false;
+
+    auto race = [&](size_t i) {
+        try {
+            std::string result = strategies[i].run(input, *oracles[i], &bound);
+            if (result.empty()) return;
+            size_t distance = editDistance(input, result);
+            std::lock_guard<std::mutex> lock(mutex);
+            logger.log(LogLevel::DEBUG, std::string("portfolio: ") + strategies[i].name + " found a repair at distance "
+                                        + std::to_string(distance));
+            if (distance < best_distance) {
+                best_distance = distance;
+                best = result;
+                *winner = strategies[i].name;
+                bound = static_cast<int>(std::min<size_t>(distance, std::numeric_limits<int>::max()));
+            }
+        } catch (const DeadlineExceeded&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            expired = true;
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error.empty()) error = strategies[i].name + std::string(": ") + e.what();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < strategies.size(); i++) threads.emplace_back(race, i);
+    if (!strategies.empty()) race(0);
+    for (auto& t : threads) t.join();
+
+    if (best.empty() && expired) throw DeadlineExceeded();
+    if (best.empty() && !error.empty()) throw std::runtime_error(error);
+    return best;
+}
+
+}  // namespace
+
+//-------------------------------------
+// 5. C interface
+//-------------------------------------
+struct repairer {
+    repair_config config;
+    std::string parser_path;
+    std::string precheck;                // format name, empty if none
+    std::vector<Precheck> prechecks;
+    bool monotone = false;               // the prefix index may infer answers
+    std::function<ParseResult(const std::string&)> parser;
+    NextBytes next;
+    RegionScan region;
+    std::unique_ptr<Speculator> speculator;
+    std::unique_ptr<Shadow> shadow;
+    double timeout = 0;                  // seconds per run, 0 = none
+    std::string error;
+};
+
+// Fast paths, shadow checks and the deadline of one run, the same for
+// every oracle of a portfolio
+static void configureOracle(repairer* r, Oracle& parser, bool has_deadline,
+                            std::chrono::steady_clock::time_point deadline) {
+    for (Precheck check : r->prechecks) parser.addPrecheck(check);
+    if (r->next) parser.nextBytesWith(r->next);
+    if (r->region) parser.regionWith(r->region);
+    if (r->shadow) {
+        parser.shadowWith(r->shadow.get(), r->config.oracle || r->config.persistent > 0
+                                           || r->parser_path != r->shadow->referenceCommand());
+    }
+    if (has_deadline) parser.setDeadline(deadline);
+}
+
+// Strategies of a portfolio: the configured DRepair first, then DRepair
+// with the other frontier order, without substitution, and span deletion
+static std::vector<Strategy> portfolioOf(const repair_config& config) {
+    BucketOrder order = config.bucket_order == REPAIR_ORDER_BOUNDARY ? BucketOrder::BOUNDARY : BucketOrder::FIFO;
+    BucketOrder other = order == BucketOrder::FIFO ? BucketOrder::BOUNDARY : BucketOrder::FIFO;
+    bool substitute = config.substitute != 0;
+    size_t memory_limit = config.memory_limit;
+    auto drepair = [memory_limit](BucketOrder o, bool sub) {
+        return [memory_limit, o, sub](const std::string& input, Oracle& parser, const std::atomic<int>* bound) {
+            return DRepair(input, parser, o, sub, memory_limit, 0, bound);
+        };
+    };
+    std::vector<Strategy> strategies;
+    strategies.push_back({ "drepair", drepair(order, substitute) });
+    strategies.push_back({ other == BucketOrder::FIFO ? "drepair-fifo" : "drepair-boundary", drepair(other, substitute) });
+    if (substitute) strategies.push_back({ "drepair-nosub", drepair(order, false) });
+    strategies.push_back({ "span", [](const std::string& input, Oracle& parser, const std::atomic<int>* bound) {
+        return SpanRepair(input, parser, bound);
+    } });
+    return strategies;
+}
+
+extern "C" {
+
+int repair_abi_version(void) {
+    return REPAIR_ABI_VERSION;
+}
+
+void repair_config_init(repair_config* config) {
+    memset(config, 0, sizeof(*config));
+    config->struct_size = sizeof(*config);
+    config->use_index = 1;
+    config->bucket_order = REPAIR_ORDER_FIFO;
+    config->substitute = 1;
+    config->speculate = -1;
+    config->shadow_rate = 0.01;
+}
+
+void repair_stats_init(repair_stats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->struct_size = sizeof(*stats);
+}
+
+void repair_shadow_stats_init(repair_shadow_stats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->struct_size = sizeof(*stats);
+}
+
+// Why the last repair_create() of this thread failed
+static thread_local std::string create_error;
+
+static repairer* createFailed(const std::string& why) {
+    create_error = why;
+    return nullptr;
+}
+
+repairer* repair_create(const repair_config* config) {
+    create_error.clear();
+    if (!config) return createFailed("no config");
+    if (config->struct_size < offsetof(repair_config, oracle_user) + sizeof(void*)) {
+        return createFailed("config struct_size too small; initialise it with repair_config_init()");
+    }
+    try {
+        std::unique_ptr<repairer> r(new repairer);
+        repair_config_init(&r->config);
+        memcpy(&r->config, config, std::min(config->struct_size, sizeof(repair_config)));
+        r->config.struct_size = sizeof(repair_config);
+
+        if (r->config.oracle) {
+            repair_oracle_fn oracle = r->config.oracle;
+            void* user = r->config.oracle_user;
+            r->parser = [oracle, user](const std::string& s) { return verdictOf(oracle(user, s.data(), s.size())); };
+        } else if (r->config.parser_path && r->config.persistent > 0) {
+            r->parser_path = r->config.parser_path;
+            auto subjects = std::make_shared<PersistentSubjects>(r->parser_path, r->config.persistent);
+            bool subject_next = r->config.next_bytes && !r->config.next_oracle && !r->config.region;
+            if (!subjects->probe(subject_next)) {
+                return createFailed(r->parser_path + (subject_next ? " does not answer next-byte queries in persistent mode"
+                                                                   : " has no persistent mode"));
+            }
+            r->parser = [subjects](const std::string& s) { return (*subjects)(s); };
+            if (subject_next) {
+                r->next = [subjects](const std::string& s, size_t len, std::bitset<256>& viable, long long& parses) {
+                    return subjects->nextBytes(s, len, viable, parses);
+                };
+            }
+        } else if (r->config.parser_path) {
+            r->parser_path = r->config.parser_path;
+            r->parser = createParser(r->parser_path);
+        } else {
+            return createFailed("no oracle: set oracle or parser_path");
+        }
+        const char* precheck = r->config.precheck;
+        const char* shadow_path = r->config.shadow_path;
+        const char* shadow_log = r->config.shadow_log;
+        if (r->config.next_bytes && r->config.next_oracle) {
+            repair_next_fn next_oracle = r->config.next_oracle;
+            void* user = r->config.oracle_user;
+            r->next = [next_oracle, user](const std::string& s, size_t len, std::bitset<256>& viable, long long&) {
+                unsigned char bitmap[32] = { 0 };
+                if (next_oracle(user, s.data(), len, bitmap) != 0) return false;
+                for (int b = 0; b < 256; b++) viable[b] = bitmap[b / 8] >> (b % 8) & 1;
+                return true;
+            };
+        }
+        if (r->config.region) {
+            const char* pattern = regexPattern(r->config.region);
+            if (!pattern) return createFailed(std::string("unknown region format ") + r->config.region);
+            auto automaton = std::make_shared<RegexAutomaton>(pattern);
+            r->region = [automaton](const std::string& s) { return automaton->region(s.data(), s.size()); };
+            // The automaton's walk answers next-byte queries without a parse
+            if (r->config.next_bytes && !r->next) {
+                r->next = [automaton](const std::string& s, size_t len, std::bitset<256>& viable, long long&) {
+                    viable = automaton->next(s.data(), len);
+                    return true;
+                };
+            }
+        }
+        if (r->config.next_bytes && !r->next) {
+            return createFailed("next_bytes needs next_oracle, a persistent subject or a region format");
+        }
+        r->config.parser_path = nullptr;     // the caller's strings are not kept
+        r->config.precheck = nullptr;
+        r->config.shadow_path = nullptr;
+        r->config.shadow_log = nullptr;
+        r->config.region = nullptr;
+
+        r->precheck = precheck ? precheck : formatOfSubject(r->parser_path);
+        if (r->precheck == "none") r->precheck.clear();
+        r->prechecks = prechecksFor(r->precheck);
+        if (!r->precheck.empty() && r->prechecks.empty()) return createFailed("unknown precheck format " + r->precheck);
+        r->monotone = r->config.use_index == 2 || monotoneFormat(formatOfSubject(r->parser_path));
+
+        // The portfolio's strategies run without speculation
+        if (r->config.speculate >= 0 && !r->config.portfolio) {
+            int jobs = r->config.jobs > 0 ? r->config.jobs : static_cast<int>(std::thread::hardware_concurrency());
+            r->speculator.reset(new Speculator(r->parser, std::max(jobs, 1)));
+        }
+        if (shadow_path) {
+            r->shadow.reset(new Shadow(shadow_path, r->config.shadow_rate, shadow_log ? shadow_log : ""));
+        }
+        return r.release();
+    } catch (const std::exception& e) {
+        return createFailed(e.what());
+    }
+}
+
+const char* repair_create_error(void) {
+    return create_error.c_str();
+}
+
+void repair_destroy(repairer* r) {
+    delete r;
+}
+
+int repair_run(repairer* r, const char* input, size_t len,
+               char** output, size_t* output_len, repair_stats* stats) {
+    if (!r) return -1;
+    if (!output || (!input && len)) {
+        r->error = "invalid arguments";
+        return -1;
+    }
+    *output = nullptr;
+    if (output_len) *output_len = 0;
+    r->error.clear();
+
+    Speculator* speculator = r->speculator.get();
+    long long spec_runs = 0, spec_useful = 0, spec_wasted = 0, spec_cancelled = 0;
+    if (speculator) {
+        spec_runs = speculator->issued;
+        spec_useful = speculator->useful;
+        spec_wasted = speculator->wasted;
+        spec_cancelled = speculator->cancelled;
+    }
+    std::vector<std::unique_ptr<Oracle>> oracles;
+    std::unique_ptr<SharedVerdicts> shared;
+    const char* winner = "";
+    // Filled in on success and on timeout, when the runs so far are known
+    auto report = [&] {
+        if (stats) {
+            repair_stats s;
+            repair_stats_init(&s);
+            for (const auto& parser : oracles) {
+                s.oracle_runs += parser->runs;
+                s.correct += parser->correct;
+                s.incorrect += parser->incorrect;
+                s.incomplete += parser->incomplete;
+                s.inferred_bad += parser->inferred_bad;
+                s.inferred_viable += parser->inferred_viable;
+                s.cached += parser->cached;
+                s.index_nodes += parser->indexed() ? parser->prefixIndex().nodeCount() : 0;
+                s.index_bytes += parser->indexed() ? parser->prefixIndex().byteCount() : 0;
+                s.prechecked += parser->prechecked;
+                s.next_queries += parser->next_queries;
+                s.next_skipped += parser->next_skipped;
+                s.next_parses += parser->next_parses;
+                s.region_scans += parser->region_scans;
+                s.region_skipped += parser->region_skipped;
+            }
+            if (shared) {
+                // The oracles' runs include the answers they got from each other
+                s.oracle_runs = shared->runs;
+                s.correct = shared->correct;
+                s.incorrect = shared->incorrect;
+                s.incomplete = shared->incomplete;
+                s.shared_hits = shared->hits;
+            }
+            s.precheck = r->precheck.c_str();
+            s.strategy = winner;
+            if (speculator) {
+                s.speculative_runs = speculator->issued - spec_runs;
+                s.speculative_useful = speculator->useful - spec_useful;
+                s.speculative_wasted = speculator->wasted - spec_wasted;
+                s.speculative_cancelled = speculator->cancelled - spec_cancelled;
+            }
+            size_t size = stats->struct_size;
+            memcpy(stats, &s, std::min(size, sizeof(s)));
+            stats->struct_size = size;
+        }
+    };
+    try {
+        bool has_deadline = r->timeout > 0;
+        std::chrono::steady_clock::time_point deadline;
+        if (has_deadline) {
+            auto budget = std::chrono::duration<double>(r->timeout);
+            deadline = std::chrono::steady_clock::now()
+                       + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget);
+        }
+
+        std::string result;
+        if (r->config.portfolio) {
+            std::vector<Strategy> strategies = portfolioOf(r->config);
+            shared.reset(new SharedVerdicts(r->parser));
+            SharedVerdicts* verdicts = shared.get();
+            for (size_t i = 0; i < strategies.size(); i++) {
+                oracles.emplace_back(new Oracle([verdicts](const std::string& s) { return (*verdicts)(s); },
+                                                r->config.use_index != 0, r->monotone));
+                configureOracle(r, *oracles.back(), has_deadline, deadline);
+            }
+            result = Portfolio(std::string(input, len), strategies, oracles, &winner);
+        } else {
+            oracles.emplace_back(new Oracle(r->parser, r->config.use_index != 0, r->monotone));
+            Oracle& parser = *oracles.back();
+            if (speculator) parser.speculate(speculator);
+            configureOracle(r, parser, has_deadline, deadline);
+
+            BucketOrder order = r->config.bucket_order == REPAIR_ORDER_BOUNDARY ? BucketOrder::BOUNDARY : BucketOrder::FIFO;
+            result = DRepair(std::string(input, len), parser, order, r->config.substitute != 0,
+                             r->config.memory_limit,
+                             r->config.speculate >= 0 ? static_cast<size_t>(r->config.speculate) : 0);
+            if (speculator) speculator->finish();
+        }
+        logger.trace("After repair", result);
+
+        report();
+        if (result.empty()) return 1;
+        char* out = static_cast<char*>(malloc(result.size() + 1));
+        if (!out) throw std::bad_alloc();
+        memcpy(out, result.data(), result.size());
+        out[result.size()] = '\0';
+        *output = out;
+        if (output_len) *output_len = result.size();
+        return 0;
+    } catch (const DeadlineExceeded& e) {
+        if (speculator) speculator->finish();
+        report();
+        r->error = e.what();
+        return 2;
+    } catch (const std::exception& e) {
+        if (speculator) speculator->finish();
+        r->error = e.what();
+        return -1;
+    }
+}
+
+void repair_set_timeout(repairer* r, double seconds) {
+    if (r) r->timeout = seconds > 0 ? seconds : 0;
+}
+
+void repair_free(char* buffer) {
+    free(buffer);
+}
+
+const char* repair_last_error(const repairer* r) {
+    return r ? r->error.c_str() : "no repairer";
+}
+
+int repair_shadow_report(repairer* r, int wait, repair_shadow_stats* stats) {
+    if (!r || !r->shadow || !stats) return -1;
+    if (wait) r->shadow->drain();
+    repair_shadow_stats s;
+    repair_shadow_stats_init(&s);
+    s.sampled = r->shadow->sampled;
+    s.dropped = r->shadow->dropped;
+    s.checked = r->shadow->checked;
+    s.mismatches = r->shadow->mismatches;
+    size_t size = stats->struct_size;
+    memcpy(stats, &s, std::min(size, sizeof(s)));
+    stats->struct_size = size;
+    return 0;
+}
+
+int repair_set_logging(int level, double progress_interval, const char* trace_path) {
+    static const LogLevel levels[] = { LogLevel::QUIET, LogLevel::INFO, LogLevel::DEBUG, LogLevel::TRACE };
+    logger.level = levels[std::min(std::max(level, 0), 3)];
+    if (progress_interval > 0) logger.progress_interval = progress_interval;
+    if (trace_path && !logger.openTrace(trace_path)) return -1;
+    return 0;
+}
+
+}  // extern "C"
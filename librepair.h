@@ -0,0 +1,190 @@
+/*-------------------------------------
+ * librepair.h
+ *
+ * C interface of the repair engine behind erepair.  A repairer holds an
+ * oracle (a subject command, as erepair takes it, or a callback) and the
+ * search options; repair_run() repairs one buffer and reports the oracle
+ * statistics of that run.  Every run starts with an empty prefix index, so
+ * a repairer can be reused for any number of records; speculative workers
+ * stay up between runs.
+ *
+ * Structs start with struct_size so fields can be added at the end without
+ * breaking callers built against an older header; always initialise them
+ * with repair_config_init() / repair_stats_init() / repair_shadow_stats_init().
+ *
+ * A repairer may be used by one thread at a time; different repairers are
+ * independent.  With speculation or a portfolio enabled the oracle (and
+ * next-byte) callback is called from worker threads as well and must be
+ * thread-safe.
+ *-------------------------------------*/
+#ifndef LIBREPAIR_H
+#define LIBREPAIR_H
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define REPAIR_API __attribute__((visibility("default")))
+#else
+#define REPAIR_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REPAIR_ABI_VERSION 1
+
+/* Oracle verdicts, the exit codes of the subjects */
+enum {
+    REPAIR_CORRECT = 0,
+    REPAIR_INCORRECT = 1,
+    REPAIR_INCOMPLETE = 255
+};
+
+/* Frontier order within an edit distance */
+enum {
+    REPAIR_ORDER_FIFO = 0,
+    REPAIR_ORDER_BOUNDARY = 1
+};
+
+/* Log levels (messages go to stderr) */
+enum {
+    REPAIR_LOG_QUIET = 0,
+    REPAIR_LOG_INFO = 1,
+    REPAIR_LOG_DEBUG = 2,
+    REPAIR_LOG_TRACE = 3
+};
+
+/* Judge data[0, len); any return value other than the verdicts above counts
+ * as REPAIR_INCORRECT. */
+typedef int (*repair_oracle_fn)(void* user, const char* data, size_t len);
+
+/* Name the bytes that may follow prefix[0, len): set bit b % 8 of
+ * viable[b / 8] unless prefix + b is certainly INCORRECT, and return 0; or
+ * return -1 to leave the question open. */
+typedef int (*repair_next_fn)(void* user, const char* prefix, size_t len, unsigned char viable[32]);
+
+typedef struct repair_config {
+    size_t struct_size;
+    const char* parser_path;      /* subject command, used when oracle is NULL */
+    repair_oracle_fn oracle;      /* in-process oracle */
+    void* oracle_user;
+    int use_index;                /* prefix index: 0 = off; 1 (default) = reuse answers,
+                                     and infer from prefixes for subjects known to be
+                                     prefix-monotone (sexp); 2 = infer for any
+                                     oracle */
+    int bucket_order;             /* REPAIR_ORDER_* (default FIFO) */
+    int substitute;               /* substitution operator (default 1) */
+    size_t memory_limit;          /* frontier bytes before spilling, 0 = none */
+    int speculate;                /* speculation window, -1 = off (default) */
+    int jobs;                     /* speculative workers, 0 = number of CPUs */
+    const char* precheck;         /* "json", "lisp", "dot", "c", "none", or
+                                     NULL for the format of parser_path */
+    const char* shadow_path;      /* reference subject command for shadow checks, NULL = off */
+    double shadow_rate;           /* fraction of fast-path answers re-checked (0..1) */
+    const char* shadow_log;       /* mismatch log file (appended), NULL = stderr at INFO */
+    int persistent;               /* > 0: keep parser_path running in its --persistent
+                                     mode, restarted every that many inputs */
+    int next_bytes;               /* restrict insertions and substitutions to the viable
+                                     next bytes, from next_oracle, the region automaton or
+                                     the persistent subject (in that order); unless the
+                                     subject is monotone (see use_index), ruled-out
+                                     edits still get one full check */
+    repair_next_fn next_oracle;   /* called with oracle_user */
+    const char* region;           /* regex format ("Date", "URL", ... as in re2_server): find
+                                     the viable prefix and dead inputs with its automaton */
+    int portfolio;                /* race DRepair variants and span deletion on separate
+                                     threads over shared oracle answers; speculate is
+                                     ignored and no speculative workers are started */
+} repair_config;
+
+typedef struct repair_stats {
+    size_t struct_size;
+    long long oracle_runs;        /* parser runs (or callbacks) the search used */
+    long long correct;
+    long long incorrect;
+    long long incomplete;
+    long long inferred_bad;       /* prefix index: INCORRECT because a prefix was */
+    long long inferred_viable;    /* prefix index: not INCORRECT because an extension was not */
+    long long cached;             /* prefix index: asked before */
+    size_t index_nodes;
+    size_t index_bytes;
+    long long prechecked;         /* rejected by a precheck, no oracle run */
+    const char* precheck;         /* precheck format in use ("" if none); owned by the repairer */
+    long long speculative_runs;
+    long long speculative_useful;
+    long long speculative_wasted;
+    long long speculative_cancelled;
+    long long next_queries;       /* next-byte answers */
+    long long next_skipped;       /* candidates they ruled out without an oracle run */
+    long long region_scans;       /* region scans in place of boundary searches and checks */
+    long long region_skipped;     /* checks they answered in place of the parser */
+    const char* strategy;         /* portfolio: the strategy whose repair was returned
+                                     ("" if none); a static string */
+    long long shared_hits;        /* portfolio: answers a strategy took from another's run */
+    long long next_parses;        /* parses the persistent subject ran for next_queries */
+} repair_stats;
+
+/* Zero *stats and set its struct_size */
+REPAIR_API void repair_stats_init(repair_stats* stats);
+
+/* Shadow checks since repair_create().  Fast-path answers are prechecks,
+ * prefix-index inferences, and the oracle itself when it is a callback or
+ * a command other than shadow_path. */
+typedef struct repair_shadow_stats {
+    size_t struct_size;
+    long long sampled;            /* fast-path answers queued for a re-check */
+    long long dropped;            /* ... not queued, the queue was full */
+    long long checked;            /* re-run against shadow_path */
+    long long mismatches;         /* ... with a different answer */
+} repair_shadow_stats;
+
+REPAIR_API void repair_shadow_stats_init(repair_shadow_stats* stats);
+
+typedef struct repairer repairer;
+
+REPAIR_API int repair_abi_version(void);
+
+/* Defaults: subject command unset, index on, FIFO, substitution on, no
+ * memory limit, no speculation, automatic prechecks, no shadow checks,
+ * one subject process per oracle run. */
+REPAIR_API void repair_config_init(repair_config* config);
+
+/* NULL if the config is unusable (no oracle, unknown precheck format,
+ * shadow log not writable, subject without a persistent mode, next_bytes
+ * without a source, unknown region format); repair_create_error() then
+ * says which. */
+REPAIR_API repairer* repair_create(const repair_config* config);
+REPAIR_API void repair_destroy(repairer* r);
+
+/* Why the calling thread's last repair_create() returned NULL, "" if it
+ * did not */
+REPAIR_API const char* repair_create_error(void);
+
+/* Repair input[0, len).  Returns 0 and a malloc'd *output (free with
+ * repair_free) when a repair was found, 1 when none was found, 2 when the
+ * run's timeout expired first, -1 on error (see repair_last_error).  stats
+ * may be NULL; on timeout it holds the oracle runs made before the deadline,
+ * on error it is not filled in. */
+REPAIR_API int repair_run(repairer* r, const char* input, size_t len,
+                          char** output, size_t* output_len, repair_stats* stats);
+REPAIR_API void repair_free(char* buffer);
+
+/* Time limit for each following repair_run() of r, 0 = none.  It is checked
+ * before every oracle run. */
+REPAIR_API void repair_set_timeout(repairer* r, double seconds);
+REPAIR_API const char* repair_last_error(const repairer* r);
+
+/* Shadow counters of r; with wait != 0, after the queued re-checks are
+ * done.  Returns -1 if r has no shadow_path. */
+REPAIR_API int repair_shadow_report(repairer* r, int wait, repair_shadow_stats* stats);
+
+/* Logging is process-wide. trace_path may be NULL. Returns -1 if the trace
+ * file cannot be opened. */
+REPAIR_API int repair_set_logging(int level, double progress_interval, const char* trace_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBREPAIR_H */
@@ -43,6 +43,9 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <ctype.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "tokens.h"
 
 //Maximum supported file size
@@ -60,6 +63,21 @@ int check_token(char* str) {
     return search(head, str);
 }
 
+// The parser reports its verdict by exiting the process. In NDJSON and
+// persistent mode every document is parsed in-process, so the verdict unwinds
+// to the per-document driver through this thread's jump buffer instead.
+static __thread jmp_buf *verdict_env = NULL;
+static void verdict_exit(int code) {
+    if (verdict_env != NULL) {
+        longjmp(*verdict_env, (code & 0xff) + 1);
+    }
+    exit(code);
+}
+
+// Set while a parse is only after the verdict: parse_number then checks the
+// number's syntax and leaves its value at 0.
+static __thread int numbers_unused = 0;
+
 #ifdef ENABLE_LOCALES
 #include <locale.h>
 #endif
@@ -81,7 +99,7 @@ typedef struct {
     const unsigned char *json;
     size_t position;
 } error;
-static error global_error = { NULL, 0 };
+static __thread error global_error = { NULL, 0 };
 
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void)
 {
@@ -278,61 +296,160 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+/* Length of the number strtod reads at the start of number[0, length): an
+ * optional sign, digits with at most one '.' among them (at least one digit),
+ * and an exponent [eE][+-]?digits when one follows; 0 if there is no number.
+ * It copies nothing and does not depend on the locale. */
+static size_t scan_number(const unsigned char * const number, const size_t length)
 {
-    double number = 0;
-    unsigned char *after_end = NULL;
+    size_t i = 0;
+    size_t digits = 0;
+    size_t mantissa_end = 0;
+
+    if ((i < length) && ((number[i] == '+') || (number[i] == '-')))
+    {
+        i++;
+    }
+    for (; (i < length) && (number[i] >= '0') && (number[i] <= '9'); i++)
+    {
+        digits++;
+    }
+    if ((i < length) && (number[i] == '.'))
+    {
+        for (i++; (i < length) && (number[i] >= '0') && (number[i] <= '9'); i++)
+        {
+            digits++;
+        }
+    }
+    if (digits == 0)
+    {
+        return 0;
+    }
+
+    mantissa_end = i;
+    if ((i < length) && ((number[i] == 'e') || (number[i] == 'E')))
+    {
+        i++;
+        if ((i < length) && ((number[i] == '+') || (number[i] == '-')))
+        {
+            i++;
+        }
+        if ((i < length) && (number[i] >= '0') && (number[i] <= '9'))
+        {
+            while ((i < length) && (number[i] >= '0') && (number[i] <= '9'))
+            {
+                i++;
+            }
+            return i;
+        }
+    }
+
+    return mantissa_end;
+}
+
+/* Value of number[0, length), a number scan_number accepted. When the digits
+ * fit in 53 bits and the power of ten is at most 10^22, both are exact doubles
+ * and one multiplication or division rounds correctly; the rest goes through
+ * strtod. */
+static double number_value(const unsigned char * const number, const size_t length)
+{
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
     unsigned char number_c_string[64];
     unsigned char decimal_point = get_decimal_point();
+    unsigned long long mantissa = 0;
+    long exponent = 0;
+    long explicit_exponent = 0;
+    cJSON_bool negative = false;
+    cJSON_bool fraction = false;
+    cJSON_bool exact = true;
+    double value = 0;
     size_t i = 0;
 
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    if ((number[i] == '+') || (number[i] == '-'))
     {
-        return false;
+        negative = number[i] == '-';
+        i++;
+    }
+    for (; (i < length) && (number[i] != 'e') && (number[i] != 'E'); i++)
+    {
+        if (number[i] == '.')
+        {
+            fraction = true;
+            continue;
+        }
+        if (mantissa > ((1ULL << 53) - 9) / 10)
+        {
+            exact = false;
+            break;
+        }
+        mantissa = mantissa * 10 + (unsigned long long)(number[i] - '0');
+        if (fraction)
+        {
+            exponent--;
+        }
+    }
+    if (exact && (i < length))
+    {
+        cJSON_bool negative_exponent = false;
+        i++;
+        if ((number[i] == '+') || (number[i] == '-'))
+        {
+            negative_exponent = number[i] == '-';
+            i++;
+        }
+        for (; (i < length) && (explicit_exponent < 1000); i++)
+        {
+            explicit_exponent = explicit_exponent * 10 + (number[i] - '0');
+        }
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+
+    if (exact && (exponent >= -22) && (exponent <= 22))
+    {
+        value = (exponent < 0) ? (double)mantissa / powers_of_ten[-exponent] : (double)mantissa * powers_of_ten[exponent];
+        return negative ? -value : value;
     }
 
     /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
-    {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_c_string[i] = buffer_at_offset(input_buffer)[i];
-                break;
+     * of the current locale (for strtod); length is below sizeof(number_c_string) */
+    for (i = 0; i < length; i++)
+    {
+        number_c_string[i] = (number[i] == '.') ? decimal_point : number[i];
+    }
+    number_c_string[length] = '\0';
 
-            case '.':
-                number_c_string[i] = decimal_point;
-                break;
+    return strtod((const char*)number_c_string, NULL);
+}
 
-            default:
-                goto loop_end;
-        }
+/* Parse the input text to generate a number, and populate the result into item.
+ * Whatever strtod reads from up to 63 bytes of [0-9+-eE.] is a number; a
+ * verdict-only parse (numbers_unused) stops at checking that. */
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+{
+    double number = 0;
+    size_t available = 0;
+    size_t length = 0;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false;
     }
-loop_end:
-    number_c_string[i] = '\0';
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
+    available = input_buffer->length - input_buffer->offset;
+    length = scan_number(buffer_at_offset(input_buffer), (available < 63) ? available : 63);
+    if (length == 0)
     {
         return false; /* parse_error */
     }
 
+    if (!numbers_unused)
+    {
+        number = number_value(buffer_at_offset(input_buffer), length);
+    }
+
     item->valuedouble = number;
 
     /* use saturation in case of overflow */
@@ -351,7 +468,7 @@ loop_end:
 
     item->type = cJSON_Number;
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
+    input_buffer->offset += length;
     return true;
 }
 
@@ -725,7 +842,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         {
             //printf("Need more chars 003.\n");
             //printf("Incomplete. 001\n");
-            exit(-1);
+            verdict_exit(-1);
             goto fail;
         }
         goto fail;
@@ -755,7 +872,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         {
             //printf("Need more chars.\n");
             //printf("Incomplete. 002\n");
-            exit(-1);
+            verdict_exit(-1);
             goto fail; /* string ended unexpectedly */
         }
 
@@ -1247,7 +1364,7 @@ static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buf
     {
         //printf("Need more chars 001.\n");
         //printf("Incomplete. 003\n");
-        exit(-1);
+        verdict_exit(-1);
         return false; /* no input */
     }
 
@@ -1310,14 +1427,14 @@ static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buf
             if (c >= 'a' && c <= 'z'){
                 continue;
             } else {
-                exit(1); // Even Whitespaces after the token should render the file INCORRECT!
+                verdict_exit(1); // Even Whitespaces after the token should render the file INCORRECT!
             }
         }
-        exit(-1); // INCOMPLETE -1
+        verdict_exit(-1); // INCOMPLETE -1
     }
     else if (is_token == INCORRECT)
     {
-        exit(1);
+        verdict_exit(1);
     }
 
     return false;
@@ -1473,11 +1590,11 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
         if (buffer_at_offset(input_buffer)[0] != NULL)
         {
           //printf("Invalid char. Expecting a closing bracket.\n");
-          exit(1);
+          verdict_exit(1);
         }
         else {
           //printf("Incomplete. 004\n");
-          exit(-1);
+          verdict_exit(-1);
           goto fail; /* expected end of array */
         }
     }
@@ -1636,14 +1753,14 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] == NULL))
         {
           //printf("Incomplete. 006\n");
-          exit(-1);
+          verdict_exit(-1);
           goto fail; /* no input */
         }
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
             //printf("Invalid char: Expecting :\n");
-            exit(1);
+            verdict_exit(1);
             goto fail; /* invalid object */
         }
 
@@ -1664,11 +1781,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
       if (buffer_at_offset(input_buffer)[0] != NULL)
       {
         //printf("Invalid char. Expecting a closing bracket.\n");
-        exit(1);
+        verdict_exit(1);
       }
       else {
         //printf("Incomplete. 005\n");
-        exit(-1);
+        verdict_exit(-1);
         goto fail; /* expected end of array */
       }
     }
@@ -3037,7 +3154,331 @@ char* read_input() {
     return chars;
 }
 
+// NDJSON mode: every line is an independent document. The input is read in
+// blocks, the complete lines of a block are validated across threads and one
+// verdict character per line is streamed out:
+//   '0' valid, '1' incorrect, '?' incomplete
+// Empty lines are skipped and get no verdict.
+// Exit code: 1 if any line is incorrect, else 255 if any is incomplete, else 0.
+#define NDJSON_BLOCK (8 * 1024 * 1024)
+#define NDJSON_ARENA (256 * 1024)
+
+// Per-thread bump allocator; a document's tree is dropped wholesale when the
+// next line starts, so documents abandoned by verdict_exit leak nothing.
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t size;
+    size_t used;
+    unsigned char data[];
+} ArenaChunk;
+static __thread ArenaChunk *arena = NULL;
+
+static void *CJSON_CDECL arena_malloc(size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    if (arena == NULL || arena->used + size > arena->size) {
+        size_t chunk_size = size > NDJSON_ARENA ? size : NDJSON_ARENA;
+        ArenaChunk *chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + chunk_size);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = arena;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        arena = chunk;
+    }
+    arena->used += size;
+    return arena->data + arena->used - size;
+}
+
+static void CJSON_CDECL arena_free(void *pointer) {
+    (void)pointer;
+}
+
+static void arena_reset(void) {
+    while (arena != NULL && arena->next != NULL) {
+        ArenaChunk *next = arena->next;
+        free(arena);
+        arena = next;
+    }
+    if (arena != NULL) {
+        arena->used = 0;
+    }
+}
+
+// Free the thread's chunks; worker threads call this before they exit
+static void arena_release(void) {
+    while (arena != NULL) {
+        ArenaChunk *next = arena->next;
+        free(arena);
+        arena = next;
+    }
+}
+
+static char validate_document(char *doc, size_t length) {
+    jmp_buf env;
+    int jumped;
+    cJSON *json;
+    if (length > CJ_BUFSIZE) {
+        return '1';   // read_input rejects oversized files
+    }
+    arena_reset();
+    numbers_unused = 1;
+    verdict_env = &env;
+    jumped = setjmp(env);
+    if (jumped) {
+        verdict_env = NULL;
+        return (jumped - 1) == 0 ? '0' : (jumped - 1) == 1 ? '1' : '?';
+    }
+    json = cJSON_Parse(doc);
+    verdict_env = NULL;
+    return json == NULL ? '1' : '0';
+}
+
+typedef struct {
+    char *begin;
+    char *end;        // one past the last byte of the job's lines
+    char *verdicts;   // one slot per line
+    size_t lines;
+    int threaded;     // run by a worker thread, to be joined
+} NdjsonJob;
+
+static void *ndjson_worker(void *arg) {
+    NdjsonJob *job = (NdjsonJob*)arg;
+    char *line = job->begin;
+    job->lines = 0;
+    while (line < job->end) {
+        char *nl = memchr(line, '\n', (size_t)(job->end - line));
+        if (nl == NULL) {
+            nl = job->end;   // only the final line of the input lacks a newline
+        }
+        *nl = '\0';
+        if (nl > line) {
+            job->verdicts[job->lines++] = validate_document(line, (size_t)(nl - line));
+        }
+        line = nl + 1;
+    }
+    return NULL;
+}
+
+// A job on its own thread; the thread's arena goes with it
+static void *ndjson_thread(void *arg) {
+    ndjson_worker(arg);
+    arena_release();
+    return NULL;
+}
+
+int ndjson_main(FILE *in, int numThreads) {
+    char *block = malloc(NDJSON_BLOCK + 1);
+    char *verdicts = malloc(NDJSON_BLOCK + 1);
+    NdjsonJob *jobs = malloc(numThreads * sizeof(NdjsonJob));
+    pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+    size_t filled = 0;
+    int any_incorrect = 0;
+    int any_incomplete = 0;
+    int eof = 0;
+
+    if (block == NULL || verdicts == NULL || jobs == NULL || threads == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        free(threads);
+        free(jobs);
+        free(verdicts);
+        free(block);
+        return 2;
+    }
+    token_trace = 0;
+    cJSON_Hooks hooks = { arena_malloc, arena_free };
+    cJSON_InitHooks(&hooks);
+    while (!eof || filled > 0) {
+        size_t got = fread(block + filled, 1, NDJSON_BLOCK - filled, in);
+        filled += got;
+        if (got == 0) {
+            eof = 1;
+        }
+        // validate every complete line; at EOF the trailing partial line too
+        char *limit = block + filled;
+        if (!eof) {
+            char *last_nl = NULL;
+            for (char *p = block + filled; p > block; p--) {
+                if (p[-1] == '\n') {
+                    last_nl = p;
+                    break;
+                }
+            }
+            if (last_nl == NULL) {
+                if (filled < NDJSON_BLOCK) {
+                    continue;   // keep reading until the line is complete
+                }
+                // a line longer than the block can never be valid; skip to its end
+                int c;
+                while ((c = fgetc(in)) != EOF && c != '\n') {
+                }
+                fputc('1', stdout);
+                any_incorrect = 1;
+                filled = 0;
+                eof = (c == EOF);
+                continue;
+            }
+            limit = last_nl;
+        }
+        if (limit == block) {
+            break;
+        }
+        // split the lines between threads on newline boundaries
+        size_t span = (size_t)(limit - block);
+        char *begin = block;
+        int used = 0;
+        for (int i = 0; i < numThreads && begin < limit; i++) {
+            char *end = (i == numThreads - 1) ? limit : block + span / numThreads * (i + 1);
+            if (end <= begin) {
+                end = begin + 1;
+            }
+            while (end < limit && end[-1] != '\n') {
+                end++;
+            }
+            jobs[used].begin = begin;
+            jobs[used].end = end;
+            jobs[used].verdicts = verdicts + (begin - block);
+            jobs[used].threaded = 0;
+            used++;
+            begin = end;
+        }
+        for (int i = 1; i < used; i++) {
+            jobs[i].threaded = pthread_create(&threads[i], NULL, ndjson_thread, &jobs[i]) == 0;
+        }
+        ndjson_worker(&jobs[0]);
+        for (int i = 1; i < used; i++) {
+            if (jobs[i].threaded) {
+                pthread_join(threads[i], NULL);
+            } else {
+                // no thread for this job: run it here
+                ndjson_worker(&jobs[i]);
+            }
+        }
+        for (int i = 0; i < used; i++) {
+            for (size_t k = 0; k < jobs[i].lines; k++) {
+                any_incorrect |= (jobs[i].verdicts[k] == '1');
+                any_incomplete |= (jobs[i].verdicts[k] == '?');
+            }
+            fwrite(jobs[i].verdicts, 1, jobs[i].lines, stdout);
+        }
+        filled -= span;
+        memmove(block, limit, filled);
+    }
+    fputc('\n', stdout);
+    fflush(stdout);
+    arena_release();
+    free(threads);
+    free(jobs);
+    free(verdicts);
+    free(block);
+    if (any_incorrect) {
+        return 1;
+    }
+    return any_incomplete ? -1 : 0;
+}
+
+// Persistent mode (--persistent [N]): one process checks N documents
+// (default 1000) and exits, so whatever the parser leaks is bounded. Each
+// document arrives on stdin as a 4-byte little-endian length and the bytes;
+// its verdict, the exit code a fresh process would have returned, is written
+// as one byte to file descriptor 3. Documents are parsed as in NDJSON mode,
+// in the arena. A length with the top bit set asks for the viable next bytes
+// of the document instead: a 32-byte bitmap of the bytes b for which
+// document + b is not INCORRECT.  The bitmap is followed by the number of
+// parses run for it, 4 bytes little-endian (see write_parses).
+static int read_record(char **data, size_t *len, int *next) {
+    unsigned char header[4];
+    if (fread(header, 1, 4, stdin) != 4) {
+        return 0;
+    }
+    *next = header[3] >> 7;
+    *len = header[0] | header[1] << 8 | header[2] << 16 | (size_t)(header[3] & 0x7f) << 24;
+    *data = malloc(*len + 2);
+    if (*data != NULL && fread(*data, 1, *len, stdin) == *len) {
+        return 1;
+    }
+    free(*data);
+    *data = NULL;
+    return 0;
+}
+
+// Sends the number of parses a next-byte answer took
+static void write_parses(FILE *out, unsigned long parses) {
+    for (int i = 0; i < 4; i++) {
+        fputc((int)(parses >> (8 * i) & 0xff), out);
+    }
+}
+
+int persistent_main(int iterations) {
+    FILE *verdicts = fdopen(3, "w");
+    if (!verdicts) {
+        fprintf(stderr, "Persistent mode needs file descriptor 3 for the verdicts\n");
+        exit(2);
+    }
+    token_trace = 0;
+    init_tri();
+    cJSON_Hooks hooks = { arena_malloc, arena_free };
+    cJSON_InitHooks(&hooks);
+    for (int n = 0; n < iterations; n++) {
+        char *data = NULL;
+        size_t len = 0;
+        int next = 0;
+        if (!read_record(&data, &len, &next)) {
+            break;
+        }
+        if (next) {
+            unsigned char viable[32] = { 0 };
+            for (int b = 0; b < 256; b++) {
+                data[len] = (char)b;
+                data[len + 1] = '\0';
+                if (validate_document(data, len + 1) != '1') {
+                    viable[b / 8] |= 1 << (b % 8);
+                }
+            }
+            fwrite(viable, 1, 32, verdicts);
+            write_parses(verdicts, 256);
+        } else {
+            data[len] = '\0';
+            char verdict = validate_document(data, len);
+            fputc(verdict == '0' ? 0 : verdict == '1' ? 1 : 255, verdicts);
+        }
+        free(data);
+        fflush(verdicts);
+    }
+    arena_release();
+    return 0;
+}
+
 int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--persistent") == 0) {
+        return persistent_main(argc > 2 ? atoi(argv[2]) : 1000);
+    }
+    if (argc > 1 && strcmp(argv[1], "--ndjson") == 0) {
+        // --ndjson [-j <threads>] [file]
+        int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        int arg = 2;
+        if (argc > arg + 1 && strcmp(argv[arg], "-j") == 0) {
+            numThreads = atoi(argv[arg + 1]);
+            arg += 2;
+        }
+        if (numThreads < 1) {
+            numThreads = 1;
+        }
+        FILE *in = stdin;
+        if (argc > arg) {
+            in = fopen(argv[arg], "r");
+            if (!in) {
+                fprintf(stderr, "Failed to open input file: %s\n", argv[arg]);
+                exit(2);
+            }
+        }
+        init_tri();
+        int ret = ndjson_main(in, numThreads);
+        if (in != stdin) {
+            fclose(in);
+        }
+        exit(ret);
+    }
     if (argc > 1) {
         // Try to open as a file, if fails, try as a file descriptor
         // Try to open as a file, if fails, try as a file descriptor
@@ -3061,6 +3502,7 @@ int main(int argc, char** argv) {
     // printf(string); // Dangerous: do not print untrusted input as format string
     printf("%s", string);
     init_tri();
+    numbers_unused = 1;
     cJSON *json = cJSON_Parse(string);
     if (argc > 1) {
         fclose(v);
@@ -32,6 +32,9 @@ void insert(struct Trie *head, char* str) {
     curr->isLeaf = 1;
 }
 
+// search() traces every visited character on stdout unless disabled
+int token_trace = 1;
+
 int is_alpha_character(char character){
     return character >= 'a' && character <= 'z';
 }
@@ -41,7 +44,9 @@ int is_alpha_character(char character){
 int search(struct Trie* head, char* str) {
     struct Trie* curr = head;
     while (is_alpha_character(*str)) {
-        printf("%d\n", *str);
+        if (token_trace) {
+            printf("%d\n", *str);
+        }
         if (*str < 'a') {
           return INCORRECT;
         }
@@ -35,6 +35,7 @@ CsvRow *CsvParser_getRow(CsvParser *csvParser);
 int CsvParser_getNumFields(CsvRow *csvRow);
 char **CsvParser_getFields(CsvRow *csvRow);
 const char* CsvParser_getErrorMessage(CsvParser *csvParser);
+int CsvParser_validate_parallel(const char *csvString, const char *delimiter, int numThreads, long *numRows, long *numFields);
 
 // Private
 CsvRow *_CsvParser_getRow(CsvParser *csvParser);    
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Differential test: csvparser -j <threads> vs. the serial csvparser.
+
+-j splits the input into newline-aligned chunks and scans them on worker
+threads (CsvParser_validate_parallel); its verdict must be the serial one for
+every input, and its ROWS / FIELDS must not depend on the number of threads.
+For inputs without quotes that end with a newline the row count is also
+checked against the rows the serial parser prints (without the final newline
+the serial parser prints a spurious last row read past the input).
+
+Inputs: the mutated texts in mutated_files/*_csv.db if there are any, and
+random CSV-like texts built from fields, delimiters, quotes and newlines.
+
+Usage:
+    python3 test_csv_parallel.py [--parser ./csvparser] [--random N] [--seed S]
+"""
+import argparse
+import glob
+import os
+import random
+import re
+import sqlite3
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.abspath(os.path.join(HERE, "..", "..", ".."))
+THREADS = (1, 2, 3, 8)
+
+
+def run(command, data):
+    with tempfile.NamedTemporaryFile(suffix=".csv", delete=False) as f:
+        f.write(data)
+        path = f.name
+    try:
+        proc = subprocess.run(command + [path], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+    finally:
+        os.remove(path)
+    # a crashed validator counts as INCORRECT, as in erepair
+    rc = proc.returncode if proc.returncode in (0, 1, 255) else 1
+    return rc, proc.stdout
+
+
+def corpus(num_random, rng):
+    for db in sorted(glob.glob(os.path.join(ROOT, "mutated_files", "*_csv.db"))):
+        conn = sqlite3.connect(db)
+        table = "mutations_triple" if db.endswith("triple_csv.db") else "mutations"
+        for (text,) in conn.execute(f"SELECT mutated_text FROM {table}"):
+            if text is not None:
+                yield text.encode("utf-8", "surrogateescape")
+        conn.close()
+    fields = [b"a", b"bc", b"12", b"", b" x ", b'"q"', b'"a,b"', b'"l1\nl2"', b'"x""y"', b'"open', b'z"']
+    for i in range(num_random):
+        quoted = i % 2 == 0
+        rows = []
+        for _ in range(rng.randint(1, 40)):
+            row = [rng.choice(fields if quoted else fields[:5]) for _ in range(rng.randint(1, 5))]
+            rows.append(b",".join(row))
+        data = rng.choice([b"\n", b"\r\n"]).join(rows)
+        if rng.random() < 0.5:
+            data += b"\n"
+        yield data
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--parser", default=os.path.join(HERE, "csvparser"))
+    ap.add_argument("--random", type=int, default=2000)
+    ap.add_argument("--seed", type=int, default=0)
+    args = ap.parse_args()
+
+    if not os.path.exists(args.parser):
+        print(f"[ERROR] validator not found: {args.parser}")
+        return 2
+
+    total = 0
+    mismatches = 0
+    for data in corpus(args.random, random.Random(args.seed)):
+        total += 1
+        want, out = run([args.parser], data)
+        problems = []
+        counts = set()
+        for n in THREADS:
+            got, summary = run([args.parser, "-j", str(n)], data)
+            if got != want:
+                problems.append(f"-j {n} verdict {got}, serial {want}")
+            counts.add(summary)
+        if len(counts) > 1:
+            problems.append(f"counts differ by thread count: {sorted(counts)}")
+        if not problems and want == 0 and b'"' not in data and data.endswith(b"\n"):
+            # the serial parser echoes the input, then one TITLE line per
+            # header field and a NEW LINE per further row
+            printed = out[len(data):].count(b"NEW LINE:\n") + 1
+            m = re.match(rb"ROWS: (\d+) FIELDS: \d+", counts.pop())
+            if m is None or int(m.group(1)) != printed:
+                problems.append(f"rows {m and m.group(1)}, serial printed {printed}")
+        if problems:
+            mismatches += 1
+            if mismatches <= 10:
+                print(f"[MISMATCH] {'; '.join(problems)} input={data[:200]!r}")
+    print(f"{total} inputs, {mismatches} mismatches")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
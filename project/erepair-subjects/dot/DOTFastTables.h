@@ -0,0 +1,207 @@
+// DOTFastTables.h -- LL(1) parse table for DOT.g4, generated by gen_ll.py; do not edit.
+//
+// Symbols: 0 = EOF, 1..24 = token types of DOT.tokens, 32 + n = nonterminal n.
+// Right-hand sides are stored reversed so they can be pushed onto the parse stack as is.
+//
+//     0  graph -> graph_1 graph_2 graph_3 '{' stmt_list '}' EOF
+//     1  graph_1 -> STRICT
+//     2  graph_1 -> <eps>
+//     3  graph_2 -> GRAPH
+//     4  graph_2 -> DIGRAPH
+//     5  graph_3 -> id_
+//     6  graph_3 -> <eps>
+//     7  stmt_list -> stmt_list_3
+//     8  id_ -> ID
+//     9  id_ -> STRING
+//    10  id_ -> HTML_STRING
+//    11  id_ -> NUMBER
+//    12  stmt_list_3 -> stmt_list_2 stmt_list_3
+//    13  stmt_list_3 -> <eps>
+//    14  stmt_list_2 -> stmt stmt_list_1
+//    15  stmt -> id_ stmt_3
+//    16  stmt -> subgraph stmt_1
+//    17  stmt -> attr_stmt
+//    18  stmt_list_1 -> ';'
+//    19  stmt_list_1 -> <eps>
+//    20  stmt_3 -> node_id_1 stmt_2
+//    21  stmt_3 -> '=' id_
+//    22  subgraph -> subgraph_3 '{' stmt_list '}'
+//    23  stmt_1 -> edgeRHS edge_stmt_2
+//    24  stmt_1 -> <eps>
+//    25  attr_stmt -> attr_stmt_1 attr_list
+//    26  node_id_1 -> port
+//    27  node_id_1 -> <eps>
+//    28  stmt_2 -> node_stmt_1
+//    29  stmt_2 -> edgeRHS edge_stmt_2
+//    30  subgraph_3 -> subgraph_2
+//    31  subgraph_3 -> <eps>
+//    32  edgeRHS -> edgeRHS_2 edgeRHS_3
+//    33  edge_stmt_2 -> attr_list
+//    34  edge_stmt_2 -> <eps>
+//    35  attr_stmt_1 -> GRAPH
+//    36  attr_stmt_1 -> NODE
+//    37  attr_stmt_1 -> EDGE
+//    38  attr_list -> attr_list_2 attr_list_3
+//    39  port -> ':' id_ port_2
+//    40  node_stmt_1 -> attr_list
+//    41  node_stmt_1 -> <eps>
+//    42  subgraph_2 -> SUBGRAPH subgraph_1
+//    43  edgeRHS_2 -> edgeop edgeRHS_1
+//    44  edgeRHS_3 -> edgeRHS_2 edgeRHS_3
+//    45  edgeRHS_3 -> <eps>
+//    46  attr_list_2 -> '[' attr_list_1 ']'
+//    47  attr_list_3 -> attr_list_2 attr_list_3
+//    48  attr_list_3 -> <eps>
+//    49  port_2 -> port_1
+//    50  port_2 -> <eps>
+//    51  subgraph_1 -> id_
+//    52  subgraph_1 -> <eps>
+//    53  edgeop -> '->'
+//    54  edgeop -> '--'
+//    55  edgeRHS_1 -> node_id
+//    56  edgeRHS_1 -> subgraph
+//    57  attr_list_1 -> a_list
+//    58  attr_list_1 -> <eps>
+//    59  port_1 -> ':' id_
+//    60  node_id -> id_ node_id_1
+//    61  a_list -> a_list_5 a_list_6
+//    62  a_list_5 -> id_ a_list_2 a_list_4
+//    63  a_list_6 -> a_list_5 a_list_6
+//    64  a_list_6 -> <eps>
+//    65  a_list_2 -> a_list_1
+//    66  a_list_2 -> <eps>
+//    67  a_list_4 -> a_list_3
+//    68  a_list_4 -> <eps>
+//    69  a_list_1 -> '=' id_
+//    70  a_list_3 -> ';'
+//    71  a_list_3 -> ','
+#pragma once
+
+#define DOT_FAST_TERMINALS    25
+#define DOT_FAST_NONTERMINALS 42
+#define DOT_FAST_NT_BASE      32
+#define DOT_FAST_START        32
+
+static const unsigned char dot_fast_rhs[] = {
+    0, 2, 36, 1, 35, 34, 33, // 0
+    11, // 1
+    // 2
+    12, // 3
+    13, // 4
+    37, // 5
+    // 6
+    38, // 7
+    19, // 8
+    18, // 9
+    20, // 10
+    17, // 11
+    38, 39, // 12
+    // 13
+    41, 40, // 14
+    42, 37, // 15
+    44, 43, // 16
+    45, // 17
+    3, // 18
+    // 19
+    47, 46, // 20
+    37, 4, // 21
+    2, 36, 1, 48, // 22
+    50, 49, // 23
+    // 24
+    52, 51, // 25
+    53, // 26
+    // 27
+    54, // 28
+    50, 49, // 29
+    55, // 30
+    // 31
+    57, 56, // 32
+    52, // 33
+    // 34
+    12, // 35
+    14, // 36
+    15, // 37
+    59, 58, // 38
+    60, 37, 10, // 39
+    52, // 40
+    // 41
+    61, 16, // 42
+    63, 62, // 43
+    57, 56, // 44
+    // 45
+    6, 64, 5, // 46
+    59, 58, // 47
+    // 48
+    65, // 49
+    // 50
+    37, // 51
+    // 52
+    8, // 53
+    9, // 54
+    66, // 55
+    43, // 56
+    67, // 57
+    // 58
+    37, 10, // 59
+    46, 37, // 60
+    69, 68, // 61
+    71, 70, 37, // 62
+    69, 68, // 63
+    // 64
+    72, // 65
+    // 66
+    73, // 67
+    // 68
+    37, 4, // 69
+    3, // 70
+    7, // 71
+};
+
+static const unsigned short dot_fast_rhs_begin[] = {
+    0, 7, 8, 8, 9, 10, 11, 11, 12, 13, 14, 15, 16, 18, 18, 20, 22, 24, 25, 26, 26, 28, 30, 34, 36, 36, 38, 39, 39, 40, 42, 43, 43, 45, 46, 46, 47, 48, 49, 51, 54, 55, 55, 57, 59, 61, 61, 64, 66, 66, 67, 67, 68, 68, 69, 70, 71, 72, 73, 73, 75, 77, 79, 82, 84, 84, 85, 85, 86, 86, 88, 89, 90
+};
+
+static const signed char dot_fast_table[DOT_FAST_NONTERMINALS][DOT_FAST_TERMINALS] = {
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  0,  0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // graph
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1,  2,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // graph_1
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  3,  4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // graph_2
+    { -1,  6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  5,  5,  5,  5, -1, -1, -1, -1},  // graph_3
+    { -1,  7,  7, -1, -1, -1, -1, -1, -1, -1, -1, -1,  7, -1,  7,  7,  7,  7,  7,  7,  7, -1, -1, -1, -1},  // stmt_list
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 11,  9,  8, 10, -1, -1, -1, -1},  // id_
+    { -1, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, 12, -1, 12, 12, 12, 12, 12, 12, 12, -1, -1, -1, -1},  // stmt_list_3
+    { -1, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 14, -1, 14, 14, 14, 14, 14, 14, 14, -1, -1, -1, -1},  // stmt_list_2
+    { -1, 16, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 17, -1, 17, 17, 16, 15, 15, 15, 15, -1, -1, -1, -1},  // stmt
+    { -1, 19, 19, 18, -1, -1, -1, -1, -1, -1, -1, -1, 19, -1, 19, 19, 19, 19, 19, 19, 19, -1, -1, -1, -1},  // stmt_list_1
+    { -1, 20, 20, 20, 21, 20, -1, -1, 20, 20, 20, -1, 20, -1, 20, 20, 20, 20, 20, 20, 20, -1, -1, -1, -1},  // stmt_3
+    { -1, 22, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 22, -1, -1, -1, -1, -1, -1, -1, -1},  // subgraph
+    { -1, 24, 24, 24, -1, -1, -1, -1, 23, 23, -1, -1, 24, -1, 24, 24, 24, 24, 24, 24, 24, -1, -1, -1, -1},  // stmt_1
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 25, -1, 25, 25, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // attr_stmt
+    { -1, 27, 27, 27, -1, 27, -1, -1, 27, 27, 26, -1, 27, -1, 27, 27, 27, 27, 27, 27, 27, -1, -1, -1, -1},  // node_id_1
+    { -1, 28, 28, 28, -1, 28, -1, -1, 29, 29, -1, -1, 28, -1, 28, 28, 28, 28, 28, 28, 28, -1, -1, -1, -1},  // stmt_2
+    { -1, 31, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 30, -1, -1, -1, -1, -1, -1, -1, -1},  // subgraph_3
+    { -1, -1, -1, -1, -1, -1, -1, -1, 32, 32, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // edgeRHS
+    { -1, 34, 34, 34, -1, 33, -1, -1, -1, -1, -1, -1, 34, -1, 34, 34, 34, 34, 34, 34, 34, -1, -1, -1, -1},  // edge_stmt_2
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 35, -1, 36, 37, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // attr_stmt_1
+    { -1, -1, -1, -1, -1, 38, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // attr_list
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 39, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // port
+    { -1, 41, 41, 41, -1, 40, -1, -1, -1, -1, -1, -1, 41, -1, 41, 41, 41, 41, 41, 41, 41, -1, -1, -1, -1},  // node_stmt_1
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 42, -1, -1, -1, -1, -1, -1, -1, -1},  // subgraph_2
+    { -1, -1, -1, -1, -1, -1, -1, -1, 43, 43, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // edgeRHS_2
+    { -1, 45, 45, 45, -1, 45, -1, -1, 44, 44, -1, -1, 45, -1, 45, 45, 45, 45, 45, 45, 45, -1, -1, -1, -1},  // edgeRHS_3
+    { -1, -1, -1, -1, -1, 46, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // attr_list_2
+    { -1, 48, 48, 48, -1, 47, -1, -1, -1, -1, -1, -1, 48, -1, 48, 48, 48, 48, 48, 48, 48, -1, -1, -1, -1},  // attr_list_3
+    { -1, 50, 50, 50, -1, 50, -1, -1, 50, 50, 49, -1, 50, -1, 50, 50, 50, 50, 50, 50, 50, -1, -1, -1, -1},  // port_2
+    { -1, 52, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 51, 51, 51, 51, -1, -1, -1, -1},  // subgraph_1
+    { -1, -1, -1, -1, -1, -1, -1, -1, 53, 54, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // edgeop
+    { -1, 56, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 56, 55, 55, 55, 55, -1, -1, -1, -1},  // edgeRHS_1
+    { -1, -1, -1, -1, -1, -1, 58, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 57, 57, 57, 57, -1, -1, -1, -1},  // attr_list_1
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 59, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // port_1
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 60, 60, 60, 60, -1, -1, -1, -1},  // node_id
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 61, 61, 61, 61, -1, -1, -1, -1},  // a_list
+    { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, 62, 62, 62, -1, -1, -1, -1},  // a_list_5
+    { -1, -1, -1, -1, -1, -1, 64, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 63, 63, 63, 63, -1, -1, -1, -1},  // a_list_6
+    { -1, -1, -1, 66, 65, -1, 66, 66, -1, -1, -1, -1, -1, -1, -1, -1, -1, 66, 66, 66, 66, -1, -1, -1, -1},  // a_list_2
+    { -1, -1, -1, 67, -1, -1, 68, 67, -1, -1, -1, -1, -1, -1, -1, -1, -1, 68, 68, 68, 68, -1, -1, -1, -1},  // a_list_4
+    { -1, -1, -1, -1, 69, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // a_list_1
+    { -1, -1, -1, 70, -1, -1, -1, 71, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},  // a_list_3
+};
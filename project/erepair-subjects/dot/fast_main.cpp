@@ -0,0 +1,310 @@
+// fast_main.cpp  – DOT validator without the ANTLR runtime (0 / 1 / 255)
+// -----------------------------------------------------------------
+//
+// Gives the same verdicts as main.cpp (dot_parser):
+//
+//   0   valid DOT
+//   1   any lexer error not at EOF OR first parser error at a non-EOF token
+//   255 lexer reached EOF inside token  OR  parser offending token == EOF
+//   2   usage / I‑O error
+//
+// The lexer is written by hand from the lexer rules of DOT.g4 (longest match,
+// earlier rule wins a tie, non-greedy STRING / TAG / COMMENT loops behave as in
+// the ANTLR lexer).  The parser is an explicit-stack LL(1) driver over the
+// table gen_ll.py generates from the parser rules (DOTFastTables.h).  An LL(1)
+// parser stops at the first token that cannot continue a valid prefix, which
+// is the token ANTLR reports first; later errors never change the verdict, so
+// both lexer and parser stop at the first ordinary error.
+//
+// test_dot_fast.py checks this binary against the ANTLR validator.
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "DOTFastTables.h"
+
+// token types of DOT.tokens
+enum {
+    TOK_EOF = 0,
+    TOK_LBRACE = 1, TOK_RBRACE, TOK_SEMI, TOK_EQUAL, TOK_LBRACKET, TOK_RBRACKET,
+    TOK_COMMA, TOK_ARROW, TOK_DASHDASH, TOK_COLON,
+    TOK_STRICT, TOK_GRAPH, TOK_DIGRAPH, TOK_NODE, TOK_EDGE, TOK_SUBGRAPH,
+    TOK_NUMBER, TOK_STRING, TOK_ID, TOK_HTML_STRING,
+    TOK_ERROR = -1,     // ordinary lexer error (or illegal UTF-8): verdict 1
+};
+
+static const int END = -1;       // end of input
+static const int ILLEGAL = -2;   // illegal UTF-8 sequence
+
+// ---------------------------------------------------------------
+// Lexer over the UTF-8 bytes; decodes code points on the fly
+// ---------------------------------------------------------------
+class Lexer {
+public:
+    bool atEOF = false;          // an unterminated token ran into EOF
+
+    Lexer(const unsigned char* begin, const unsigned char* end) : p(begin), end(end) {}
+
+    int next() {
+        for (;;) {
+            const unsigned char* q;
+            long c = at(p, &q);
+            switch (c) {
+            case END:     return TOK_EOF;
+            case ILLEGAL: return TOK_ERROR;
+            case '{': p = q; return TOK_LBRACE;
+            case '}': p = q; return TOK_RBRACE;
+            case ';': p = q; return TOK_SEMI;
+            case '=': p = q; return TOK_EQUAL;
+            case '[': p = q; return TOK_LBRACKET;
+            case ']': p = q; return TOK_RBRACKET;
+            case ',': p = q; return TOK_COMMA;
+            case ':': p = q; return TOK_COLON;
+            case '-':
+                if (q < end && *q == '>') { p = q + 1; return TOK_ARROW; }
+                if (q < end && *q == '-') { p = q + 1; return TOK_DASHDASH; }
+                return number();
+            case '"': return string(q);
+            case '<': return html(q);
+            case '/':
+                if (!comment(q)) return atEOF ? TOK_EOF : TOK_ERROR;
+                continue;
+            case '#':                                    // PREPROC: '#' ~[\r\n]*
+                for (p = q; (c = at(p, &q)) >= 0 && c != '\r' && c != '\n'; p = q) {}
+                if (c == ILLEGAL) return TOK_ERROR;
+                continue;
+            case ' ': case '\t': case '\r': case '\n':
+                p = q;
+                continue;
+            default:
+                if (c == '.' || isDigit(c)) return number();
+                if (isLetter(c)) return identifier(q);
+                return TOK_ERROR;
+            }
+        }
+    }
+
+private:
+    const unsigned char* p;
+    const unsigned char* end;
+
+    static bool isDigit(long c)  { return c >= '0' && c <= '9'; }
+    static bool isLetter(long c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (c >= 0x80 && c <= 0xFF);
+    }
+
+    // Code point at s (strict UTF-8, as ANTLRInputStream decodes), END or ILLEGAL.
+    long at(const unsigned char* s, const unsigned char** next) const {
+        if (s >= end) { *next = s; return END; }
+        unsigned c = s[0];
+        if (c < 0x80) { *next = s + 1; return c; }
+        int len;
+        unsigned lo = 0x80, hi = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF)      { len = 2; c &= 0x1F; }
+        else if (c >= 0xE0 && c <= 0xEF) { len = 3; c &= 0x0F; if (c == 0x0) lo = 0xA0; if (c == 0xD) hi = 0x9F; }
+        else if (c >= 0xF0 && c <= 0xF4) { len = 4; c &= 0x07; if (c == 0x0) lo = 0x90; if (c == 0x4) hi = 0x8F; }
+        else return ILLEGAL;
+        if (end - s < len) return ILLEGAL;
+        for (int i = 1; i < len; i++) {
+            unsigned b = s[i];
+            if (b < lo || b > hi) return ILLEGAL;
+            lo = 0x80; hi = 0xBF;
+            c = (c << 6) | (b & 0x3F);
+        }
+        *next = s + len;
+        return c;
+    }
+
+    // No rule matched and nothing was accepted: an error at EOF is an
+    // incomplete token, anywhere else it is an ordinary lexer error.
+    int fail(const unsigned char* s) {
+        const unsigned char* q;
+        long c = at(s, &q);
+        if (c != END) return TOK_ERROR;
+        atEOF = true;
+        p = end;
+        return TOK_EOF;
+    }
+
+    // NUMBER: '-'? ('.' DIGIT+ | DIGIT+ ('.' DIGIT*)?)
+    int number() {
+        const unsigned char* s = p;
+        if (*s == '-') s++;
+        if (s < end && isDigit(*s)) {
+            while (s < end && isDigit(*s)) s++;
+            if (s < end && *s == '.') {
+                s++;
+                while (s < end && isDigit(*s)) s++;
+            }
+            p = s;
+            return TOK_NUMBER;
+        }
+        if (s < end && *s == '.') {
+            s++;
+            if (s < end && isDigit(*s)) {
+                while (s < end && isDigit(*s)) s++;
+                p = s;
+                return TOK_NUMBER;
+            }
+        }
+        return fail(s);
+    }
+
+    // STRING: '"' ('\\"' | .)*? '"'
+    // A quote after a backslash may either close the string or be escaped;
+    // the lexer keeps going and falls back to that quote if nothing longer
+    // matches.
+    int string(const unsigned char* s) {
+        const unsigned char* accept = nullptr;
+        bool backslash = false;
+        for (;;) {
+            const unsigned char* q;
+            long c = at(s, &q);
+            if (c == ILLEGAL) return TOK_ERROR;
+            if (c == END) {
+                if (!accept) return fail(s);
+                p = accept;
+                return TOK_STRING;
+            }
+            s = q;
+            if (c == '"') {
+                if (!backslash) { p = s; return TOK_STRING; }
+                accept = s;
+                backslash = false;
+            } else {
+                backslash = (c == '\\');
+            }
+        }
+    }
+
+    // HTML_STRING: '<' (TAG | ~[<>])* '>'  with  TAG: '<' .*? '>'
+    // Once inside a tag the TAG loop stays live; a '>' closes the string
+    // whenever the outer loop is live too, otherwise it ends the tag and
+    // revives the outer loop.
+    int html(const unsigned char* s) {
+        bool outer = true;
+        for (;;) {
+            const unsigned char* q;
+            long c = at(s, &q);
+            if (c == ILLEGAL) return TOK_ERROR;
+            if (c == END) return fail(s);
+            s = q;
+            if (c == '>') {
+                if (outer) { p = s; return TOK_HTML_STRING; }
+                outer = true;
+            } else if (c == '<') {
+                outer = false;
+            }
+        }
+    }
+
+    // COMMENT: '/*' .*? '*/'   LINE_COMMENT: '//' .*? '\r'? '\n'
+    // Returns true when a comment was skipped.
+    bool comment(const unsigned char* s) {
+        const unsigned char* q;
+        long c = at(s, &q);
+        if (c == '*' || c == '/') {
+            const unsigned char* r = q;
+            for (;;) {
+                long d = at(r, &q);
+                if (d == ILLEGAL) return false;
+                if (d == END) { fail(r); return false; }
+                r = q;
+                if (c == '/' && d == '\n') break;
+                if (c == '*' && d == '*' && r < end && *r == '/') { r++; break; }
+            }
+            p = r;
+            return true;
+        }
+        if (c == ILLEGAL) return false;
+        fail(s);
+        return false;
+    }
+
+    int identifier(const unsigned char* s) {
+        const unsigned char* q;
+        for (;;) {
+            long c = at(s, &q);
+            if (c == ILLEGAL) return TOK_ERROR;
+            if (!isLetter(c) && !isDigit(c)) break;
+            s = q;
+        }
+        int type = keyword(p, s - p);
+        p = s;
+        return type;
+    }
+
+    // Keywords are case-insensitive and win a tie against ID.
+    static int keyword(const unsigned char* s, size_t n) {
+        static const struct { const char* text; int type; } keywords[] = {
+            {"strict", TOK_STRICT}, {"graph", TOK_GRAPH}, {"digraph", TOK_DIGRAPH},
+            {"node", TOK_NODE},     {"edge", TOK_EDGE},   {"subgraph", TOK_SUBGRAPH},
+        };
+        for (const auto& k : keywords) {
+            if (strlen(k.text) != n) continue;
+            size_t i = 0;
+            while (i < n && s[i] < 0x80 && (s[i] | 0x20) == k.text[i]) i++;
+            if (i == n) return k.type;
+        }
+        return TOK_ID;
+    }
+};
+
+// ---------------------------------------------------------------
+// LL(1) driver
+// ---------------------------------------------------------------
+static int validate(const unsigned char* begin, const unsigned char* end)
+{
+    Lexer lexer(begin, end);
+    std::vector<unsigned char> stack;
+    stack.reserve(256);
+    stack.push_back(DOT_FAST_START);
+
+    int tok = lexer.next();
+    while (!stack.empty()) {
+        if (tok == TOK_ERROR) return 1;
+        int top = stack.back();
+        stack.pop_back();
+        if (top < DOT_FAST_NT_BASE) {                   // terminal
+            if (top != tok) return tok == TOK_EOF ? 255 : 1;
+            if (tok != TOK_EOF) tok = lexer.next();
+            continue;
+        }
+        int prod = dot_fast_table[top - DOT_FAST_NT_BASE][tok];
+        if (prod < 0) return tok == TOK_EOF ? 255 : 1;
+        stack.insert(stack.end(), dot_fast_rhs + dot_fast_rhs_begin[prod],
+                                  dot_fast_rhs + dot_fast_rhs_begin[prod + 1]);
+    }
+    return lexer.atEOF ? 255 : 0;
+}
+
+int main(int argc, const char* argv[]) {
+    /* ---------- 0. file open ------------------------------------- */
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <file.dot>\n", argv[0]);
+        return 2;
+    }
+
+    FILE* in = nullptr;
+    if (strncmp(argv[1], "/dev/fd/", 8) == 0) {
+        int fd = atoi(argv[1] + 8);
+        if (fd > 0) in = fdopen(fd, "rb");
+    }
+    if (!in) in = fopen(argv[1], "rb");
+    if (!in) { perror("open"); return 2; }
+
+    std::string text;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, in)) > 0) text.append(buf, n);
+    fclose(in);
+
+    /* ---------- 1. lex + parse ----------------------------------- */
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = begin + text.size();
+    if (text.size() >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0) begin += 3;   // BOM, as ANTLRInputStream
+    return validate(begin, end);
+}
@@ -0,0 +1,347 @@
+#!/usr/bin/env python3
+"""
+gen_ll.py - generate the predictive parse table used by dot_fast.
+
+Reads the parser rules of DOT.g4 (token numbers from DOT.tokens), rewrites the
+EBNF into plain BNF, and then makes the grammar LL(1) by repeatedly
+  * left-factoring alternatives that start with the same symbol, and
+  * inlining the leading nonterminal of alternatives whose predict sets clash.
+The result is written as DOTFastTables.h: a dense [nonterminal][token] table of
+production numbers plus the right-hand sides, which fast_main.cpp drives with an
+explicit stack.
+
+DOT needs no lookahead beyond one token once stmt / edge_stmt / node_stmt are
+factored, so the table is LL(1); the generator refuses to emit anything that is
+not.
+
+Usage:
+    python3 gen_ll.py [DOT.g4] [DOT.tokens] [-o DOTFastTables.h]
+"""
+import argparse
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+EOF = 0
+
+TOKEN_RE = re.compile(r"""
+    (?P<lit>'(?:\\.|[^'\\])*')
+  | (?P<set>\[(?:\\.|[^\]\\])*\])
+  | (?P<name>[A-Za-z_][A-Za-z0-9_]*)
+  | (?P<arrow>->)
+  | (?P<ws>\s+|/\*.*?\*/|//[^\n]*)
+  | (?P<op>.)
+""", re.S | re.X)
+
+
+def read_tokens(path):
+    types = {}
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not line:
+                continue
+            name, _, value = line.rpartition("=")
+            types[name] = int(value)
+    types["EOF"] = EOF
+    return types
+
+
+def read_rules(path):
+    """Return {rule: token list} for the parser (lower-case) rules of a .g4 file."""
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    toks = [(m.lastgroup, m.group()) for m in TOKEN_RE.finditer(text) if m.lastgroup != "ws"]
+    rules, i = {}, 0
+    while i < len(toks):
+        kind, value = toks[i]
+        if kind == "name" and value == "grammar":
+            i += 3                                   # grammar NAME ;
+            continue
+        if kind == "name" and value == "fragment":
+            i += 1
+            continue
+        if kind == "name" and i + 1 < len(toks) and toks[i + 1] == ("op", ":"):
+            j = i + 2
+            while toks[j] != ("op", ";"):
+                j += 1
+            if value[0].islower():
+                rules[value] = toks[i + 2:j]
+            i = j + 1
+            continue
+        raise SystemExit(f"gen_ll: unexpected {value!r} in {path}")
+    return rules
+
+
+class Grammar:
+    def __init__(self, start):
+        self.start = start
+        self.prods = {}                              # nonterminal -> [tuple(symbols)]
+        self.order = []
+
+    def add(self, nt, alts):
+        if nt not in self.prods:
+            self.order.append(nt)
+        self.prods[nt] = [tuple(a) for a in alts]
+
+    def fresh(self, base):
+        n = 1
+        while f"{base}_{n}" in self.prods:
+            n += 1
+        name = f"{base}_{n}"
+        self.add(name, [])
+        return name
+
+    # -------------------------------------------------------------- EBNF -> BNF
+    def lower(self, rule, toks, types):
+        pos = [0]
+
+        def peek():
+            return toks[pos[0]] if pos[0] < len(toks) else (None, None)
+
+        def alternatives():
+            alts = [sequence()]
+            while peek() == ("op", "|"):
+                pos[0] += 1
+                alts.append(sequence())
+            return alts
+
+        def sequence():
+            seq = []
+            while True:
+                kind, value = peek()
+                if kind is None or (kind, value) in (("op", "|"), ("op", ")")):
+                    return seq
+                pos[0] += 1
+                if kind == "lit":
+                    sym = types[value]
+                elif kind == "name":
+                    sym = value if value[0].islower() else types[value]
+                elif (kind, value) == ("op", "("):
+                    alts = alternatives()
+                    if peek() != ("op", ")"):
+                        raise SystemExit(f"gen_ll: missing ')' in rule {rule}")
+                    pos[0] += 1
+                    sym = self.fresh(rule)
+                    self.add(sym, alts)
+                else:
+                    raise SystemExit(f"gen_ll: unsupported {value!r} in rule {rule}")
+                kind, value = peek()
+                if (kind, value) in (("op", "?"), ("op", "*"), ("op", "+")):
+                    pos[0] += 1
+                    if value == "?":
+                        opt = self.fresh(rule)
+                        self.add(opt, [[sym], []])
+                        sym = opt
+                    else:
+                        star = self.fresh(rule)
+                        self.add(star, [[sym, star], []])
+                        if value == "+":
+                            seq.append(sym)
+                        sym = star
+                seq.append(sym)
+
+        self.add(rule, alternatives())
+
+    # ------------------------------------------------------------- FIRST/FOLLOW
+    def analyse(self):
+        self.nullable = set()
+        self.first = {nt: set() for nt in self.prods}
+        changed = True
+        while changed:
+            changed = False
+            for nt, alts in self.prods.items():
+                for alt in alts:
+                    f, null = self.first_of(alt)
+                    if null and nt not in self.nullable:
+                        self.nullable.add(nt)
+                        changed = True
+                    if not f <= self.first[nt]:
+                        self.first[nt] |= f
+                        changed = True
+        self.follow = {nt: set() for nt in self.prods}
+        self.follow[self.start].add(EOF)
+        changed = True
+        while changed:
+            changed = False
+            for nt, alts in self.prods.items():
+                for alt in alts:
+                    for i, sym in enumerate(alt):
+                        if not isinstance(sym, str):
+                            continue
+                        f, null = self.first_of(alt[i + 1:])
+                        if null:
+                            f = f | self.follow[nt]
+                        if not f <= self.follow[sym]:
+                            self.follow[sym] |= f
+                            changed = True
+
+    def first_of(self, seq):
+        out = set()
+        for sym in seq:
+            if not isinstance(sym, str):
+                out.add(sym)
+                return out, False
+            out |= self.first[sym]
+            if sym not in self.nullable:
+                return out, False
+        return out, True
+
+    def predict(self, nt, alt):
+        f, null = self.first_of(alt)
+        return f | self.follow[nt] if null else f
+
+    def conflict(self):
+        """First (nonterminal, clashing alternative indices) found, or None."""
+        for nt in self.order:
+            alts = self.prods[nt]
+            sets = [self.predict(nt, a) for a in alts]
+            clash = set()
+            for i in range(len(alts)):
+                for j in range(i + 1, len(alts)):
+                    if sets[i] & sets[j]:
+                        clash |= {i, j}
+            if clash:
+                return nt, sorted(clash)
+        return None
+
+    # ----------------------------------------------------------- LL(1) rewrite
+    def height(self, sym, seen=()):
+        if not isinstance(sym, str) or sym in seen:
+            return 0
+        return 1 + max((self.height(a[0], seen + (sym,)) for a in self.prods[sym] if a), default=0)
+
+    def factor(self, nt, idx):
+        alts = self.prods[nt]
+        groups = {}
+        for i in idx:
+            if alts[i]:
+                groups.setdefault(alts[i][0], []).append(i)
+        shared = [g for g in groups.values() if len(g) > 1]
+        if shared:
+            group = shared[0]
+            prefix = list(alts[group[0]])
+            for i in group[1:]:
+                n = 0
+                while n < min(len(prefix), len(alts[i])) and prefix[n] == alts[i][n]:
+                    n += 1
+                prefix = prefix[:n]
+            tail = self.fresh(nt)
+            self.add(tail, [alts[i][len(prefix):] for i in group])
+            kept = [a for i, a in enumerate(alts) if i not in group]
+            self.prods[nt] = [tuple(prefix + [tail])] + kept
+            return True
+        leading = [i for i in idx if alts[i] and isinstance(alts[i][0], str) and alts[i][0] != nt]
+        if not leading:
+            return False
+        i = max(leading, key=lambda i: self.height(alts[i][0]))
+        head, rest = alts[i][0], alts[i][1:]
+        inlined = [tuple(a) + rest for a in self.prods[head]]
+        self.prods[nt] = alts[:i] + inlined + alts[i + 1:]
+        return True
+
+    def make_ll1(self, limit=200):
+        for _ in range(limit):
+            self.analyse()
+            found = self.conflict()
+            if found is None:
+                self.prune()
+                self.analyse()
+                return
+            nt, idx = found
+            if not self.factor(nt, idx):
+                break
+        raise SystemExit(f"gen_ll: grammar is not LL(1) at {found[0]}: "
+                         + " | ".join(" ".join(map(str, self.prods[found[0]][i])) for i in found[1]))
+
+    def prune(self):
+        reach, todo = [], [self.start]
+        while todo:
+            nt = todo.pop(0)
+            if nt in reach:
+                continue
+            reach.append(nt)
+            for alt in self.prods[nt]:
+                todo.extend(s for s in alt if isinstance(s, str) and s not in reach)
+        self.order = reach
+        self.prods = {nt: self.prods[nt] for nt in reach}
+
+
+def emit(g, types, out):
+    names = {v: k for k, v in types.items()}
+    names[EOF] = "EOF"
+    terminals = max(types.values()) + 1
+    index = {nt: i for i, nt in enumerate(g.order)}
+    base = 32
+    assert terminals <= base
+
+    def code(sym):
+        return base + index[sym] if isinstance(sym, str) else sym
+
+    rhs, begin, table, comments = [], [], [], []
+    for nt in g.order:
+        row = [-1] * terminals
+        for alt in g.prods[nt]:
+            p = len(begin)
+            begin.append(len(rhs))
+            rhs.extend(code(s) for s in reversed(alt))
+            comments.append(f"{nt} -> " + (" ".join(s if isinstance(s, str) else names[s] for s in alt) or "<eps>"))
+            for t in g.predict(nt, alt):
+                row[t] = p
+        table.append(row)
+    begin.append(len(rhs))
+    if len(begin) > 127:
+        raise SystemExit("gen_ll: too many productions for a signed char table")
+
+    w = out.write
+    w("// DOTFastTables.h -- LL(1) parse table for DOT.g4, generated by gen_ll.py; do not edit.\n")
+    w("//\n")
+    w("// Symbols: 0 = EOF, 1..%d = token types of DOT.tokens, %d + n = nonterminal n.\n" % (terminals - 1, base))
+    w("// Right-hand sides are stored reversed so they can be pushed onto the parse stack as is.\n")
+    w("//\n")
+    for p, c in enumerate(comments):
+        w(f"//   {p:3d}  {c}\n")
+    w("#pragma once\n\n")
+    w(f"#define DOT_FAST_TERMINALS    {terminals}\n")
+    w(f"#define DOT_FAST_NONTERMINALS {len(g.order)}\n")
+    w(f"#define DOT_FAST_NT_BASE      {base}\n")
+    w(f"#define DOT_FAST_START        {base + index[g.start]}\n\n")
+    w("static const unsigned char dot_fast_rhs[] = {\n")
+    for p in range(len(begin) - 1):
+        w("    " + "".join(f"{s}, " for s in rhs[begin[p]:begin[p + 1]]) + f"// {p}\n")
+    w("};\n\n")
+    w("static const unsigned short dot_fast_rhs_begin[] = {\n    ")
+    w(", ".join(map(str, begin)))
+    w("\n};\n\n")
+    w("static const signed char dot_fast_table[DOT_FAST_NONTERMINALS][DOT_FAST_TERMINALS] = {\n")
+    for nt, row in zip(g.order, table):
+        w("    {" + ",".join(f"{v:3d}" for v in row) + f"}},  // {nt}\n")
+    w("};\n")
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("grammar", nargs="?", default=os.path.join(HERE, "DOT.g4"))
+    ap.add_argument("tokens", nargs="?", default=os.path.join(HERE, "DOT.tokens"))
+    ap.add_argument("-o", "--output", default=os.path.join(HERE, "DOTFastTables.h"))
+    args = ap.parse_args()
+
+    types = read_tokens(args.tokens)
+    rules = read_rules(args.grammar)
+    start = next(iter(rules))
+    g = Grammar(start)
+    for name, toks in rules.items():
+        g.add(name, [])
+    for name, toks in rules.items():
+        g.lower(name, toks, types)
+    g.make_ll1()
+    with open(args.output, "w", encoding="utf-8") as out:
+        emit(g, types, out)
+    print(f"[gen_ll] {len(g.order)} nonterminals, "
+          f"{sum(len(a) for a in g.prods.values())} productions -> {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
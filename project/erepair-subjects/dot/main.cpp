@@ -6,9 +6,16 @@
 //   255 lexer reached EOF inside token  OR  parser offending token == EOF
 //   2   usage / I‑O error
 //
+// With --persistent [N] it checks a stream of inputs instead (see
+// persistentMain), re-lexing only around the bytes that changed.
+//
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "antlr4-runtime.h"
 #include "DOTLexer.h"
@@ -49,8 +56,47 @@ public:
 #include <fcntl.h>
 #include <unistd.h>
 
+#include "incremental_relex.h"
+
+// ---------------------------------------------------------------
+// Persistent mode (--persistent [N]): see incremental_relex.h
+// ---------------------------------------------------------------
+typedef IncrementalValidator<DOTLexer, DOTParser, ErrorFlags> Validator;
+
+int persistentMain(int iterations) {
+    FILE* verdicts = fdopen(3, "w");
+    if (!verdicts) {
+        std::cerr << "Persistent mode needs file descriptor 3 for the verdicts\n";
+        return 2;
+    }
+    Validator validator([](DOTParser& parser) { parser.graph(); });
+    std::string data;
+    for (int n = 0; n < iterations; n++) {
+        bool next = false;
+        if (!readRecord(data, next)) break;
+        if (next) {
+            unsigned char viable[32] = { 0 };
+            data.push_back('\0');
+            for (int b = 0; b < 256; b++) {
+                data.back() = static_cast<char>(b);
+                unsigned char verdict = validator.check(data);
+                if (verdict == 0 || verdict == 255) viable[b / 8] |= 1 << (b % 8);
+            }
+            fwrite(viable, 1, 32, verdicts);
+            writeParses(verdicts, 256);
+        } else {
+            fputc(validator.check(data), verdicts);
+        }
+        fflush(verdicts);
+    }
+    return 0;
+}
+
 int main(int argc, const char* argv[]) {
     /* ---------- 0. file open ------------------------------------- */
+    if (argc > 1 && strcmp(argv[1], "--persistent") == 0) {
+        return persistentMain(argc > 2 ? atoi(argv[2]) : 1000);
+    }
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " <file.dot>\n";
         return 2;
@@ -0,0 +1,410 @@
+#!/usr/bin/env python3
+"""
+Differential test: dot_fast (generated LL(1) recognizer) vs. the ANTLR DOT validator.
+
+Both must return the same 0 / 1 / 255 verdict for every input. The reference is
+either the ANTLR-built `dot_parser` binary (--reference build/dot_parser) or, by
+default, the ANTLR Python runtime driving the very same serialized ATNs that
+DOTLexer.cpp / DOTParser.cpp embed (DOTLexer.interp / DOT.interp), with the
+ErrorFlags precedence logic of main.cpp.
+
+Inputs: the seed files in original_files/dot_data, the mutated texts in
+mutated_files/*_dot.db, and random byte-level mutations of the seeds.
+
+Usage:
+    python3 test_dot_fast.py [--fast build/dot_fast] [--reference build/dot_parser]
+                             [--random N] [--seed S]
+"""
+import argparse
+import glob
+import os
+import random
+import sqlite3
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.abspath(os.path.join(HERE, "..", "..", ".."))
+
+
+def load_interp(path):
+    sections = {}
+    name = None
+    with open(path, encoding="utf-8") as f:
+        for line in f.read().split("\n"):
+            if line.endswith(":") and not line.startswith("'"):
+                name = line[:-1]
+                sections[name] = []
+            elif line and name is not None:
+                sections[name].append(line)
+    atn = [int(x) for x in sections["atn"][0].strip("[]").split(",")]
+    return sections, atn
+
+
+def python_reference():
+    """Build a verdict function from the .interp ATNs with the ANTLR Python runtime."""
+    from antlr4 import CommonTokenStream, InputStream, Lexer, Parser, ParserRuleContext
+    from antlr4.PredictionContext import PredictionContextCache
+    from antlr4.atn.ATNDeserializer import ATNDeserializer
+    from antlr4.atn.LexerATNSimulator import LexerATNSimulator
+    from antlr4.atn.ParserATNSimulator import ParserATNSimulator
+    from antlr4.dfa.DFA import DFA
+    from antlr4.error.ErrorListener import ErrorListener
+    from antlr4.error.Errors import NoViableAltException, RecognitionException
+    from antlr4.Token import Token
+
+    lex_sections, lex_atn = load_interp(os.path.join(HERE, "DOTLexer.interp"))
+    par_sections, par_atn = load_interp(os.path.join(HERE, "DOT.interp"))
+    lexer_atn = ATNDeserializer().deserialize(lex_atn)
+    parser_atn = ATNDeserializer().deserialize(par_atn)
+    literal = ["<INVALID>" if n == "null" else n for n in par_sections["token literal names"]]
+    symbolic = ["<INVALID>" if n == "null" else n for n in par_sections["token symbolic names"]]
+
+    class DOTLexer(Lexer):
+        atn = lexer_atn
+        decisionsToDFA = [DFA(ds, i) for i, ds in enumerate(lexer_atn.decisionToState)]
+        grammarFileName = "DOT.g4"
+        ruleNames = lex_sections["rule names"]
+        literalNames = literal
+        symbolicNames = symbolic
+        modeNames = lex_sections["mode names"]
+        channelNames = lex_sections["channel names"]
+
+        def __init__(self, input):
+            super().__init__(input)
+            self._interp = LexerATNSimulator(self, self.atn, self.decisionsToDFA, PredictionContextCache())
+
+    ID_SET = (1 << 17) | (1 << 18) | (1 << 19) | (1 << 20)   # NUMBER STRING ID HTML_STRING
+
+    class Context(ParserRuleContext):
+        def __init__(self, parent, invokingState, ruleIndex):
+            super().__init__(parent, invokingState)
+            self.ruleIndex = ruleIndex
+
+        def getRuleIndex(self):
+            return self.ruleIndex
+
+    def rule(index, state):
+        # enterRule / catch RecognitionException / exitRule, as in every DOTParser.cpp rule
+        def wrap(body):
+            def method(self):
+                ctx = Context(self._ctx, self.state, index)
+                self.enterRule(ctx, state, index)
+                try:
+                    body(self, ctx)
+                except RecognitionException as e:
+                    ctx.exception = e
+                    self._errHandler.reportError(self, e)
+                    self._errHandler.recover(self, e)
+                finally:
+                    self.exitRule()
+                return ctx
+            return method
+        return wrap
+
+    class DOTParser(Parser):
+        """Hand transliteration of the rule methods generated into DOTParser.cpp."""
+        atn = parser_atn
+        decisionsToDFA = [DFA(ds, i) for i, ds in enumerate(parser_atn.decisionToState)]
+        grammarFileName = "DOT.g4"
+        ruleNames = par_sections["rule names"]
+        literalNames = literal
+        symbolicNames = symbolic
+
+        def __init__(self, input):
+            super().__init__(input)
+            self._interp = ParserATNSimulator(self, self.atn, self.decisionsToDFA, PredictionContextCache())
+
+        def la(self):
+            return self._input.LA(1)
+
+        def match_set(self, state, bits):
+            self.state = state
+            la = self.la()
+            if la < 0 or not (bits >> la) & 1:
+                self._errHandler.recoverInline(self)
+            else:
+                self._errHandler.reportMatch(self)
+                self.consume()
+
+        def sync(self, state):
+            self.state = state
+            self._errHandler.sync(self)
+            return self.la()
+
+        def at(self, state, bits):
+            la = self.sync(state)
+            return la >= 0 and (bits >> la) & 1
+
+        @rule(0, 0)
+        def graph(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            if self.sync(29) == 11:
+                self.state = 28; self.match(11)
+            self.match_set(31, (1 << 12) | (1 << 13))
+            if self.at(33, ID_SET):
+                self.state = 32; self.id_()
+            self.state = 35; self.match(1)
+            self.state = 36; self.stmt_list()
+            self.state = 37; self.match(2)
+            self.state = 38; self.match(Token.EOF)
+
+        @rule(1, 2)
+        def stmt_list(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            state = 46
+            while self.at(state, 2084866):
+                self.state = 40; self.stmt()
+                if self.sync(42) == 3:
+                    self.state = 41; self.match(3)
+                state = 48
+
+        @rule(2, 4)
+        def stmt(self, ctx):
+            self.sync(57)
+            alt = self._interp.adaptivePredict(self._input, 4, self._ctx)
+            self.enterOuterAlt(ctx, alt)
+            if alt == 1:
+                self.state = 49; self.node_stmt()
+            elif alt == 2:
+                self.state = 50; self.edge_stmt()
+            elif alt == 3:
+                self.state = 51; self.attr_stmt()
+            elif alt == 4:
+                self.state = 52; self.id_()
+                self.state = 53; self.match(4)
+                self.state = 54; self.id_()
+            elif alt == 5:
+                self.state = 56; self.subgraph()
+
+        @rule(3, 6)
+        def attr_stmt(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.match_set(59, 53248)
+            self.state = 60; self.attr_list()
+
+        @rule(4, 8)
+        def attr_list(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.sync(67)
+            while True:
+                self.state = 62; self.match(5)
+                if self.at(64, ID_SET):
+                    self.state = 63; self.a_list()
+                self.state = 66; self.match(6)
+                if self.sync(69) != 5:
+                    break
+
+        @rule(5, 10)
+        def a_list(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.sync(79)
+            while True:
+                self.state = 71; self.id_()
+                if self.sync(74) == 4:
+                    self.state = 72; self.match(4)
+                    self.state = 73; self.id_()
+                if self.sync(77) in (3, 7):
+                    self.match_set(76, (1 << 3) | (1 << 7))
+                if not self.at(81, ID_SET):
+                    break
+
+        def node_or_subgraph(self, state, node_state, subgraph_state):
+            la = self.sync(state)
+            if la >= 0 and (ID_SET >> la) & 1:
+                self.state = node_state; self.node_id()
+            elif la in (1, 16):
+                self.state = subgraph_state; self.subgraph()
+            else:
+                raise NoViableAltException(self)
+
+        @rule(6, 12)
+        def edge_stmt(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.node_or_subgraph(85, 83, 84)
+            self.state = 87; self.edgeRHS()
+            if self.sync(89) == 5:
+                self.state = 88; self.attr_list()
+
+        @rule(7, 14)
+        def edgeRHS(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.sync(96)
+            while True:
+                self.state = 91; self.edgeop()
+                self.node_or_subgraph(94, 92, 93)
+                if self.sync(98) not in (8, 9):
+                    break
+
+        @rule(8, 16)
+        def edgeop(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.match_set(100, (1 << 8) | (1 << 9))
+
+        @rule(9, 18)
+        def node_stmt(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.state = 102; self.node_id()
+            if self.sync(104) == 5:
+                self.state = 103; self.attr_list()
+
+        @rule(10, 20)
+        def node_id(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.state = 106; self.id_()
+            if self.sync(108) == 10:
+                self.state = 107; self.port()
+
+        @rule(11, 22)
+        def port(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.state = 110; self.match(10)
+            self.state = 111; self.id_()
+            if self.sync(114) == 10:
+                self.state = 112; self.match(10)
+                self.state = 113; self.id_()
+
+        @rule(12, 24)
+        def subgraph(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            if self.sync(120) == 16:
+                self.state = 116; self.match(16)
+                if self.at(118, ID_SET):
+                    self.state = 117; self.id_()
+            self.state = 122; self.match(1)
+            self.state = 123; self.stmt_list()
+            self.state = 124; self.match(2)
+
+        @rule(13, 26)
+        def id_(self, ctx):
+            self.enterOuterAlt(ctx, 1)
+            self.match_set(126, ID_SET)
+
+    class ErrorFlags(ErrorListener):
+        # mirrors ErrorFlags in main.cpp
+        def __init__(self):
+            self.lexerOrdinary = self.lexerAtEOF = False
+            self.parserOrdinary = self.parserAtEOF = False
+
+        def syntaxError(self, recognizer, offendingSymbol, line, column, msg, e):
+            if offendingSymbol is None:
+                if isinstance(recognizer, Lexer) and recognizer._input.LA(1) == Token.EOF:
+                    self.lexerAtEOF = True
+                else:
+                    self.lexerOrdinary = True
+            elif offendingSymbol.type == Token.EOF:
+                self.parserAtEOF = True
+            else:
+                self.parserOrdinary = True
+
+    def verdict(data):
+        if data.startswith(b"\xef\xbb\xbf"):
+            data = data[3:]
+        try:
+            text = data.decode("utf-8")
+        except UnicodeDecodeError:
+            return 1   # ANTLRInputStream throws; the process dies -> INCORRECT
+        flags = ErrorFlags()
+        lexer = DOTLexer(InputStream(text))
+        parser = DOTParser(CommonTokenStream(lexer))
+        lexer.removeErrorListeners()
+        parser.removeErrorListeners()
+        lexer.addErrorListener(flags)
+        parser.addErrorListener(flags)
+        parser.graph()
+        if flags.lexerOrdinary or flags.parserOrdinary:
+            return 1
+        if flags.lexerAtEOF or flags.parserAtEOF:
+            return 255
+        return 0
+
+    return verdict
+
+
+def binary_verdict(binary, data):
+    with tempfile.NamedTemporaryFile(suffix=".dot", delete=False) as f:
+        f.write(data)
+        path = f.name
+    try:
+        rc = subprocess.run([binary, path], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL).returncode
+    finally:
+        os.remove(path)
+    # a crashed validator (e.g. illegal UTF-8) counts as INCORRECT, as in erepair
+    return rc if rc in (0, 1, 255) else 1
+
+
+def corpus(num_random, rng):
+    seeds = []
+    for path in sorted(glob.glob(os.path.join(ROOT, "original_files", "dot_data", "*.dot"))):
+        with open(path, "rb") as f:
+            seeds.append(f.read())
+    yield from seeds
+    for db in sorted(glob.glob(os.path.join(ROOT, "mutated_files", "*_dot.db"))):
+        conn = sqlite3.connect(db)
+        table = "mutations_triple" if db.endswith("triple_dot.db") else "mutations"
+        for (text,) in conn.execute(f"SELECT mutated_text FROM {table}"):
+            if text is not None:
+                yield text.encode("utf-8", "surrogateescape")
+        conn.close()
+    alphabet = b'{}[];=,:-><"\\/*#\n \t.0aZ_\x80\xc3\xa9'
+    # short token soups exercise the lexer corners (escaped quotes, nested
+    # HTML tags, unterminated comments, '-' / '.' numbers) more densely
+    fragments = [b"digraph", b"graph ", b"strict ", b"Node", b"edge", b"subgraph", b"{", b"}", b";",
+                 b"=", b"[", b"]", b",", b":", b"->", b"--", b"-", b".", b"1", b"-2.", b".5", b"a",
+                 b'"', b'\\"', b"\\", b"<", b">", b"/*", b"*/", b"//", b"\n", b"#", b" ", b"\xc3\xa9", b"@"]
+    for i in range(num_random):
+        if i % 4 == 3:
+            yield b"".join(rng.choice(fragments) for _ in range(rng.randint(1, 16)))
+            continue
+        data = bytearray(rng.choice(seeds)) if seeds else bytearray()
+        for _ in range(rng.randint(1, 3)):
+            pos = rng.randint(0, len(data))
+            op = rng.randint(0, 3)
+            if op == 0 and pos < len(data):
+                del data[pos]
+            elif op == 1:
+                data[pos:pos] = bytes([rng.choice(alphabet)])
+            elif op == 2 and pos < len(data):
+                data[pos] = rng.choice(alphabet)
+            else:
+                data = data[:pos]   # truncation
+        yield bytes(data)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--fast", default=os.path.join(HERE, "build", "dot_fast"))
+    ap.add_argument("--reference", default=None, help="ANTLR dot_parser binary (default: Python runtime)")
+    ap.add_argument("--random", type=int, default=2000)
+    ap.add_argument("--seed", type=int, default=0)
+    args = ap.parse_args()
+
+    if not os.path.exists(args.fast):
+        print(f"[ERROR] fast recognizer not found: {args.fast}")
+        return 2
+    if args.reference:
+        reference = lambda data: binary_verdict(args.reference, data)
+    else:
+        try:
+            reference = python_reference()
+        except ImportError as e:
+            print(f"[ERROR] antlr4-python3-runtime is required without --reference: {e}")
+            return 2
+
+    total = 0
+    mismatches = 0
+    for data in corpus(args.random, random.Random(args.seed)):
+        total += 1
+        want = reference(data)
+        got = binary_verdict(args.fast, data)
+        if want != got:
+            mismatches += 1
+            if mismatches <= 10:
+                print(f"[FAIL] expected {want}, got {got}: {data[:200]!r}")
+    print(f"[TEST] {total} inputs, {mismatches} mismatches")
+    return 0 if mismatches == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
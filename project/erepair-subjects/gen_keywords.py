@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+gen_keywords.py - generate the keyword recognizer of the tiny and tri subjects.
+
+Both subjects used to insert their keywords into a malloc'ed trie at startup
+and walk it for every token, printing the characters they visited. This
+writes the same trie as nested switch statements over str[0], str[1], ...
+into a header (tokens.h), so a lookup is a few compares and nothing is
+allocated or printed.
+
+search_keyword(str), for a NUL-terminated str, keeps the verdicts of the old
+search():
+  VALID       str is a keyword; with --prefix, str starts with one (the rest
+              of str is not looked at, as in tiny's search)
+  INCOMPLETE  str ends inside a keyword (the empty string included)
+  INCORRECT   anything else
+
+With --next, next_keyword_bytes(str, viable) walks the same trie and sets bit b % 8 of
+viable[b / 8] for each byte b for which search_keyword(str + b) is not
+INCORRECT: the edges out of the node str ends at, and NUL (which ends the
+string), or every byte once a --prefix keyword is spelled.  It answers a
+next-byte query of the persistent mode without a parse.
+
+Usage:
+    python3 gen_keywords.py [--prefix] [--next] [-o tokens.h] word...
+"""
+import argparse
+import sys
+
+
+def trie(words):
+    root = {}
+    for word in words:
+        node = root
+        for c in word:
+            node = node.setdefault(c, {})
+        node[""] = {}   # end of a keyword
+    return root
+
+
+def emit(node, depth, prefix, lines):
+    pad = "    " * (depth + 1)
+    lines.append(f"{pad}switch (str[{depth}]) {{")
+    for c in sorted(k for k in node if k):
+        child = node[c]
+        lines.append(f"{pad}case '{c}':")
+        if prefix and "" in child:
+            lines.append(f"{pad}    return VALID;")
+        else:
+            emit(child, depth + 1, prefix, lines)
+    lines.append(f"{pad}case '\\0':")
+    lines.append(f"{pad}    return {'VALID' if '' in node else 'INCOMPLETE'};")
+    lines.append(f"{pad}default:")
+    lines.append(f"{pad}    return INCORRECT;")
+    lines.append(f"{pad}}}")
+
+
+def emit_next(node, depth, prefix, lines):
+    pad = "    " * (depth + 1)
+    lines.append(f"{pad}switch (str[{depth}]) {{")
+    for c in sorted(k for k in node if k):
+        child = node[c]
+        lines.append(f"{pad}case '{c}':")
+        if prefix and "" in child:
+            lines.append(f"{pad}    for (int i = 0; i < 32; i++) viable[i] = 0xff;")
+            lines.append(f"{pad}    return;")
+        else:
+            emit_next(child, depth + 1, prefix, lines)
+    lines.append(f"{pad}case '\\0':")
+    lines.append(f"{pad}    viable[0] |= 1;   /* NUL */")
+    for c in sorted(k for k in node if k):
+        lines.append(f"{pad}    viable[{ord(c) // 8}] |= {1 << ord(c) % 8};   /* '{c}' */")
+    lines.append(f"{pad}    return;")
+    lines.append(f"{pad}default:")
+    lines.append(f"{pad}    return;")
+    lines.append(f"{pad}}}")
+
+
+def generate(words, prefix, next_bytes, command):
+    for word in words:
+        if not word or not all("a" <= c <= "z" for c in word):
+            raise SystemExit(f"gen_keywords.py: keywords are lowercase letters: {word!r}")
+    root = trie(words)
+    lines = [
+        f"// tokens.h -- keyword recognizer for {' '.join(words)}; generated by",
+        f"// {command}, do not edit.",
+        "#ifndef TOKENS_H",
+        "#define TOKENS_H",
+        "",
+        "#define VALID 0",
+        "#define INCOMPLETE -1",
+        "#define INCORRECT 1",
+        "",
+        "static int search_keyword(const char* str) {",
+    ]
+    emit(root, 0, prefix, lines)
+    lines.append("}")
+    if next_bytes:
+        lines += ["", "static void next_keyword_bytes(const char* str, unsigned char viable[32]) {"]
+        emit_next(root, 0, prefix, lines)
+        lines.append("}")
+    lines += ["", "#endif", ""]
+    return "\n".join(lines)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--prefix", action="store_true", help="VALID as soon as a keyword is spelled")
+    ap.add_argument("--next", action="store_true", help="also emit next_keyword_bytes()")
+    ap.add_argument("-o", "--output", default="tokens.h")
+    ap.add_argument("words", nargs="+")
+    args = ap.parse_args()
+    command = ("gen_keywords.py " + ("--prefix " if args.prefix else "") + ("--next " if args.next else "")
+               + " ".join(args.words))
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(generate(args.words, args.prefix, args.next, command))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
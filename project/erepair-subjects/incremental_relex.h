@@ -0,0 +1,181 @@
+// incremental_relex.h  – persistent mode of the ANTLR validators (dot, obj)
+// -----------------------------------------------------------------
+//
+// The protocol of the C subjects' --persistent [N] mode: each input
+// arrives on stdin as a 4-byte little-endian length and the bytes, its
+// verdict goes to file descriptor 3 as one byte; a length with the top
+// bit set asks for the 32-byte bitmap of the bytes b for which input + b
+// is not INCORRECT, followed by the number of parses run for it (4 bytes,
+// little-endian).  Exits after N inputs (default 1000).
+//
+// Successive inputs differ in a few bytes, so the token stream of the
+// previous input is kept.  Tokens whose lexing looked only at the common
+// prefix are reused; lexing restarts after the last of them and stops as
+// soon as it reaches, inside the common suffix, a position where lexing
+// started for an old token.  From there the old tokens are shifted and
+// spliced in, since the lexer (one mode, no actions) is a function of the
+// remaining text.  Only the parser goes over the whole stream again.
+//
+// The including main.cpp defines ErrorFlags, its error listener, first.
+//
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "antlr4-runtime.h"
+
+// Input stream that records the furthest index the lexer looked at
+class TrackingInputStream : public antlr4::ANTLRInputStream {
+public:
+    size_t reach = 0;
+
+    size_t LA(ssize_t i) override {
+        if (i > 0) reach = std::max(reach, index() + static_cast<size_t>(i) - 1);
+        return antlr4::ANTLRInputStream::LA(i);
+    }
+
+    // Loads the next input and measures, in code points, what it shares
+    // with the previous one at the start and at the end
+    void reload(const std::string& bytes, size_t& prefix, size_t& suffix) {
+        previous.swap(_data);
+        load(bytes, false);
+        size_t n = std::min(previous.size(), _data.size());
+        for (prefix = 0; prefix < n && previous[prefix] == _data[prefix]; prefix++) {}
+        for (suffix = 0; suffix < n - prefix
+             && previous[previous.size() - 1 - suffix] == _data[_data.size() - 1 - suffix]; suffix++) {}
+    }
+
+    void forget() {
+        previous.clear();
+        _data.clear();
+        seek(0);
+    }
+
+private:
+    decltype(_data) previous;
+};
+
+struct LexedToken {
+    std::unique_ptr<antlr4::Token> token;
+    size_t from = 0, next = 0;      // input index before and after nextToken()
+    size_t reach = 0;               // furthest index nextToken() looked at
+    bool lexerOrdinary = false;     // lexer errors raised by that call
+    bool lexerAtEOF = false;
+};
+
+// Verdicts (0 / 1 / 255) of Parser's start rule over successive inputs
+template <class Lexer, class Parser, class Flags>
+class IncrementalValidator {
+public:
+    typedef void (*StartRule)(Parser&);
+
+    explicit IncrementalValidator(StartRule start) : start(start), lexer(&input) {
+        lexer.removeErrorListeners();
+        lexer.addErrorListener(&lexerFlags);
+    }
+
+    unsigned char check(const std::string& bytes) {
+        size_t old_size = input.size(), prefix, suffix;
+        try {
+            input.reload(bytes, prefix, suffix);
+        } catch (const std::exception&) {       // illegal UTF-8: a fresh process aborts
+            input.forget();
+            tokens.clear();
+            return 1;
+        }
+        relex(old_size, prefix, suffix);
+
+        // The parser takes copies; they refer to lexer and input, which live on
+        std::vector<std::unique_ptr<antlr4::Token>> copies;
+        copies.reserve(tokens.size());
+        for (const auto& t : tokens) copies.push_back(std::make_unique<antlr4::CommonToken>(t.token.get()));
+        antlr4::ListTokenSource source(std::move(copies));
+        antlr4::CommonTokenStream stream(&source);
+        Parser parser(&stream);
+        Flags flags;
+        parser.removeErrorListeners();
+        parser.addErrorListener(&flags);
+        start(parser);
+
+        // A fresh process lexes only the tokens the parser asked for
+        size_t fetched = std::min(stream.size(), tokens.size());
+        for (size_t i = 0; i < fetched; i++) {
+            flags.lexerOrdinary |= tokens[i].lexerOrdinary;
+            flags.lexerAtEOF |= tokens[i].lexerAtEOF;
+        }
+        if (flags.lexerOrdinary || flags.parserOrdinary)   return 1;
+        if (flags.lexerAtEOF    || flags.parserAtEOF)      return 255;
+        return 0;
+    }
+
+private:
+    StartRule start;
+    TrackingInputStream input;
+    Lexer lexer;
+    Flags lexerFlags;
+    std::vector<LexedToken> tokens;
+
+    void relex(size_t old_size, size_t prefix, size_t suffix) {
+        size_t new_size = input.size();
+        size_t delta = new_size - old_size;     // added to old positions, modulo 2^n
+        std::vector<LexedToken> old;
+        old.swap(tokens);
+        size_t k = 0;
+        for (; k < old.size() && old[k].reach < prefix; k++) tokens.push_back(std::move(old[k]));
+
+        lexer.reset();
+        input.seek(tokens.empty() ? 0 : tokens.back().next);
+        for (size_t j = k;;) {
+            size_t from = input.index();
+            if (from >= new_size - suffix) {
+                size_t old_from = from - delta;
+                while (j < old.size() && old[j].from < old_from) j++;
+                if (j < old.size() && old[j].from == old_from) {
+                    for (; j < old.size(); j++) {
+                        LexedToken& t = old[j];
+                        auto* token = static_cast<antlr4::CommonToken*>(t.token.get());
+                        token->setStartIndex(token->getStartIndex() + delta);
+                        token->setStopIndex(token->getStopIndex() + delta);
+                        t.from += delta;
+                        t.next += delta;
+                        t.reach += delta;
+                        tokens.push_back(std::move(t));
+                    }
+                    return;
+                }
+            }
+            LexedToken t;
+            t.from = from;
+            input.reach = from;
+            lexerFlags.lexerOrdinary = lexerFlags.lexerAtEOF = false;
+            t.token = lexer.nextToken();
+            t.next = input.index();
+            t.reach = input.reach;
+            t.lexerOrdinary = lexerFlags.lexerOrdinary;
+            t.lexerAtEOF = lexerFlags.lexerAtEOF;
+            bool eof = t.token->getType() == antlr4::Token::EOF;
+            tokens.push_back(std::move(t));
+            if (eof) return;
+        }
+    }
+};
+
+// Reads one input record; next: the top bit of its length was set
+inline bool readRecord(std::string& data, bool& next) {
+    unsigned char header[4];
+    if (fread(header, 1, 4, stdin) != 4) return false;
+    next = header[3] >> 7;
+    size_t len = header[0] | header[1] << 8 | header[2] << 16 | static_cast<size_t>(header[3] & 0x7f) << 24;
+    data.resize(len);
+    return fread(&data[0], 1, len, stdin) == len;
+}
+
+// Sends the number of parses a next-byte answer took
+inline void writeParses(FILE* out, unsigned long parses) {
+    for (int i = 0; i < 4; i++) fputc(static_cast<int>(parses >> (8 * i) & 0xff), out);
+}
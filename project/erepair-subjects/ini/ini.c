@@ -20,6 +20,7 @@ https://github.com/benhoyt/inih
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
+#include <setjmp.h>
 
 #include "ini.h"
 
@@ -316,6 +317,17 @@ static int handler(void* user, const char* section, const char* name,
     return 1;
 }
 
+// The subject reports an oversized input by exiting the process.  In
+// persistent mode the verdict unwinds to the per-input driver through this
+// jump buffer instead.
+jmp_buf *verdict_env = NULL;
+void verdict_exit(int code) {
+    if (verdict_env != NULL) {
+        longjmp(*verdict_env, (code & 0xff) + 1);
+    }
+    exit(code);
+}
+
 FILE* v = 0;
 char* read_input() {
     int counter = 0;
@@ -323,7 +335,7 @@ char* read_input() {
     int c = 0;
     while((c = fgetc(v)) != EOF){
         if (counter == MAXFILESIZE) {
-            exit(-1);
+            verdict_exit(-1);
         }
         if (c == '\0'){
             c = 'X'; // Ugly workaround for dealing with 0 bytes in corrupted files
@@ -334,8 +346,126 @@ char* read_input() {
     return chars;
 }
 
-int main(int argc, char** argv) {
+// Verdict for a whole file, from the line ini_parse_string() stopped at
+int check_string(char* string) {
     configuration config;
+    int actual_linenos = 1; // Ugly workaround for detecting empty lines at the end of the file
+    for (char* c = string; *c; c++){
+        if (*c == '\n'){
+            actual_linenos++;
+        }
+    }
+
+    int ret = ini_parse_string(string, handler, &config);
+    printf("\nLineno %d/%d", ret, actual_linenos);
+
+    if (ret > 0){
+        if (ret >= actual_linenos){
+            if (comment_after_incomplete){
+                return 1; // Incomplete, but there was a comment afterwards
+            } else {
+                return -1; // Incomplete - Error occurred in last line
+            }
+        } else {
+            return 1; // Incorrect - Error occurred somewhere in the middle of the file
+        }
+    } else if (ret < 0) {
+        return 1; // File IO Error?
+    }
+    return 0; // Valid
+}
+
+// Persistent mode (--persistent [N]): one process checks N inputs (default
+// 1000) and exits, so whatever the parser leaks is bounded.  Each input
+// arrives on stdin as a 4-byte little-endian length and the bytes; its
+// verdict, the exit code a fresh process would have returned, is written as
+// one byte to file descriptor 3.
+// A length with the top bit set asks for the viable next bytes of the
+// input instead: a 32-byte bitmap of the bytes b for which input + b is not
+// INCORRECT (verdict 0 or 255).  The bitmap is followed by the number of
+// parses run for it, 4 bytes little-endian (see write_parses).
+int read_record(char** data, size_t* len, int* next) {
+    unsigned char header[4];
+    if (fread(header, 1, 4, stdin) != 4) {
+        return 0;
+    }
+    *next = header[3] >> 7;
+    *len = header[0] | header[1] << 8 | header[2] << 16 | (size_t)(header[3] & 0x7f) << 24;
+    *data = malloc(*len + 2);
+    if (*data != NULL && fread(*data, 1, *len, stdin) == *len) {
+        return 1;
+    }
+    free(*data);
+    *data = NULL;
+    return 0;
+}
+
+// Sends the number of parses a next-byte answer took
+void write_parses(FILE* out, unsigned long parses) {
+    for (int i = 0; i < 4; i++) {
+        fputc((int)(parses >> (8 * i) & 0xff), out);
+    }
+}
+
+// Verdict for one input, as a fresh process would exit with it
+unsigned char check_record(char* data, size_t len) {
+    v = fmemopen(data, len, "r");
+    comment_after_incomplete = 0;
+    char* volatile string = NULL;   // read after a longjmp
+    jmp_buf env;
+    int jumped;
+    unsigned char verdict;
+    verdict_env = &env;
+    jumped = setjmp(env);
+    if (jumped) {
+        verdict = jumped - 1;
+    } else {
+        string = read_input();
+        verdict = check_string(string);
+    }
+    verdict_env = NULL;
+    fclose(v);
+    free(string);
+    return verdict;
+}
+
+int persistent_main(int iterations) {
+    FILE* verdicts = fdopen(3, "w");
+    if (!verdicts) {
+        fprintf(stderr, "Persistent mode needs file descriptor 3 for the verdicts\n");
+        exit(2);
+    }
+    for (int n = 0; n < iterations; n++) {
+        char* data = NULL;
+        size_t len = 0;
+        int next = 0;
+        if (!read_record(&data, &len, &next)) {
+            break;
+        }
+        if (next) {
+            unsigned char viable[32] = { 0 };
+            for (int b = 0; b < 256; b++) {
+                data[len] = (char)b;
+                unsigned char verdict = check_record(data, len + 1);
+                if (verdict == 0 || verdict == 255) {
+                    viable[b / 8] |= 1 << (b % 8);
+                }
+            }
+            fwrite(viable, 1, 32, verdicts);
+            write_parses(verdicts, 256);
+        } else {
+            fputc(check_record(data, len), verdicts);
+        }
+        free(data);
+        fflush(verdicts);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--persistent") == 0) {
+        return persistent_main(argc > 2 ? atoi(argv[2]) : 1000);
+    }
     if (argc > 1) {
         // Try to open as a file, if fails, try as a file descriptor
         v = fopen(argv[1], "r");
@@ -365,34 +495,11 @@ int main(int argc, char** argv) {
     //printf(str);
     //printf("\n");
     //free(str);
-    int actual_linenos = 1; // Ugly workaround for detecting empty lines at the end of the file
-    for (char* c = string; *c; c++){
-        if (*c == '\n'){
-            actual_linenos++;
-        }
-    }
-
-    int ret = ini_parse_string(string, handler, &config);
-    printf("\nLineno %d/%d", ret, actual_linenos);
+    int verdict = check_string(string);
 
     // Only close v if it was opened (not stdin)
     if (argc > 1 && v && v != stdin) {
         fclose(v);
     }
-
-    if (ret > 0){
-        if (ret >= actual_linenos){
-            if (comment_after_incomplete){
-                return 1; // Incomplete, but there was a comment afterwards
-            } else {
-                return -1; // Incomplete - Error occurred in last line
-            }
-        } else {
-            return 1; // Incorrect - Error occurred somewhere in the middle of the file
-        }
-    } else if (ret < 0) {
-        return 1; // File IO Error?
-    }
-    return 0; // Valid
-
+    return verdict;
 }
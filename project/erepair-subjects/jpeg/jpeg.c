@@ -0,0 +1,787 @@
+// NanoJPEG -- KeyJ's Tiny Baseline JPEG Decoder
+// version 1.1 (2010-03-05)
+// by Martin J. Fiedler <martin.fiedler@gmx.net>
+// http://keyj.emphy.de/nanojpeg/
+//
+// This software is published under the terms of KeyJ's Research License,
+// version 0.2. Usage of this software is subject to the following conditions:
+// 0. There's no warranty whatsoever. The author(s) of this software can not
+//    be held liable for any damages that occur when using this software.
+// 1. This software may be used freely for both non-commercial and commercial
+//    purposes.
+// 2. This software may be redistributed freely as long as no fees are charged
+//    for the distribution and this license information is included.
+// 3. This software may be modified freely except for this license information,
+//    which must not be changed in any way.
+// 4. If anything other than configuration, indentation or comments have been
+//    altered in the code, the original author(s) must receive a copy of the
+//    modified code.
+//
+// Adapted as an erepair subject: the decoder judges one JPEG stream and exits
+// with the oracle verdicts instead of returning an nj_result_t.
+//   0    CORRECT     a complete baseline JPEG that decodes: SOI, the tables,
+//                    one frame, one scan, EOI and nothing after it
+//   1    INCORRECT   a syntax error, or a stream NanoJPEG does not support
+//                    (progressive, 12-bit, CMYK, ...), which the Python
+//                    subject (../nanojpeg.py) rejected as well
+//   255  INCOMPLETE  the stream is a proper prefix of one that may still
+//                    decode: it ends inside a marker, a segment, the entropy
+//                    coded data or before EOI
+// A segment length is trusted for the structure of the segment, so a prefix
+// that ends inside a segment is INCOMPLETE whatever its declared length.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+#define CORRECT 0
+#define INCORRECT 1
+#define INCOMPLETE 255
+
+typedef struct _nj_code {
+    unsigned char bits, code;
+} nj_vlc_code_t;
+
+typedef struct _nj_cmp {
+    int cid;
+    int ssx, ssy;
+    int width, height;
+    int stride;
+    int qtsel;
+    int actabsel, dctabsel;
+    int dcpred;
+    unsigned char *pixels;
+} nj_component_t;
+
+typedef struct _nj_ctx {
+    const unsigned char *pos;
+    size_t size;            // bytes left in the input
+    int length;             // bytes left in the current segment
+    int width, height;
+    int mbwidth, mbheight;
+    int mbsizex, mbsizey;
+    int ncomp;
+    nj_component_t comp[3];
+    int qtused, qtavail;
+    unsigned char qtab[4][64];
+    int vlcavail;           // Huffman tables defined by a DHT
+    unsigned int buf, bufbits;
+    int block[64];
+    int rstinterval;
+    int eoi;                // the bit reader ran into EOI
+    size_t trailing;        // ... with that many bytes after it
+    unsigned char *rgb;
+} nj_context_t;
+
+static nj_context_t nj;
+// Outside nj, which is cleared for every input: a table is only read once
+// vlcavail says this input defined it
+static nj_vlc_code_t nj_vlctab[4][65536];
+
+static const char njZZ[64] = { 0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18,
+11, 4, 5, 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28, 35,
+42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45,
+38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+// A verdict other than CORRECT leaves the decoder through this jump buffer
+static jmp_buf nj_fail;
+#define njThrow(verdict) longjmp(nj_fail, (verdict) + 1)
+
+// The next n bytes of the input, or INCOMPLETE
+static void njNeed(size_t n) {
+    if (nj.size < n) njThrow(INCOMPLETE);
+}
+
+// The next byte must be b, if the input has one
+static void njExpect(size_t offset, unsigned char b) {
+    if (nj.size > offset && nj.pos[offset] != b) njThrow(INCORRECT);
+}
+
+static unsigned char njClip(const int x) {
+    return (x < 0) ? 0 : ((x > 0xFF) ? 0xFF : (unsigned char) x);
+}
+
+#define W1 2841
+#define W2 2676
+#define W3 2408
+#define W5 1609
+#define W6 1108
+#define W7 565
+
+static void njRowIDCT(int* blk) {
+    int x0, x1, x2, x3, x4, x5, x6, x7, x8;
+    if (!((x1 = blk[4] * 2048)
+        | (x2 = blk[6])
+        | (x3 = blk[2])
+        | (x4 = blk[1])
+        | (x5 = blk[7])
+        | (x6 = blk[5])
+        | (x7 = blk[3])))
+    {
+        blk[0] = blk[1] = blk[2] = blk[3] = blk[4] = blk[5] = blk[6] = blk[7] = blk[0] * 8;
+        return;
+    }
+    x0 = (blk[0] * 2048) + 128;
+    x8 = W7 * (x4 + x5);
+    x4 = x8 + (W1 - W7) * x4;
+    x5 = x8 - (W1 + W7) * x5;
+    x8 = W3 * (x6 + x7);
+    x6 = x8 - (W3 - W5) * x6;
+    x7 = x8 - (W3 + W5) * x7;
+    x8 = x0 + x1;
+    x0 -= x1;
+    x1 = W6 * (x3 + x2);
+    x2 = x1 - (W2 + W6) * x2;
+    x3 = x1 + (W2 - W6) * x3;
+    x1 = x4 + x6;
+    x4 -= x6;
+    x6 = x5 + x7;
+    x5 -= x7;
+    x7 = x8 + x3;
+    x8 -= x3;
+    x3 = x0 + x2;
+    x0 -= x2;
+    x2 = (181 * (x4 + x5) + 128) >> 8;
+    x4 = (181 * (x4 - x5) + 128) >> 8;
+    blk[0] = (x7 + x1) >> 8;
+    blk[1] = (x3 + x2) >> 8;
+    blk[2] = (x0 + x4) >> 8;
+    blk[3] = (x8 + x6) >> 8;
+    blk[4] = (x8 - x6) >> 8;
+    blk[5] = (x0 - x4) >> 8;
+    blk[6] = (x3 - x2) >> 8;
+    blk[7] = (x7 - x1) >> 8;
+}
+
+static void njColIDCT(const int* blk, unsigned char *out, int stride) {
+    int x0, x1, x2, x3, x4, x5, x6, x7, x8;
+    if (!((x1 = blk[8*4] * 256)
+        | (x2 = blk[8*6])
+        | (x3 = blk[8*2])
+        | (x4 = blk[8*1])
+        | (x5 = blk[8*7])
+        | (x6 = blk[8*5])
+        | (x7 = blk[8*3])))
+    {
+        x1 = njClip(((blk[0] + 32) >> 6) + 128);
+        for (x0 = 8;  x0;  --x0) {
+            *out = (unsigned char) x1;
+            out += stride;
+        }
+        return;
+    }
+    x0 = (blk[0] * 256) + 8192;
+    x8 = W7 * (x4 + x5) + 4;
+    x4 = (x8 + (W1 - W7) * x4) >> 3;
+    x5 = (x8 - (W1 + W7) * x5) >> 3;
+    x8 = W3 * (x6 + x7) + 4;
+    x6 = (x8 - (W3 - W5) * x6) >> 3;
+    x7 = (x8 - (W3 + W5) * x7) >> 3;
+    x8 = x0 + x1;
+    x0 -= x1;
+    x1 = W6 * (x3 + x2) + 4;
+    x2 = (x1 - (W2 + W6) * x2) >> 3;
+    x3 = (x1 + (W2 - W6) * x3) >> 3;
+    x1 = x4 + x6;
+    x4 -= x6;
+    x6 = x5 + x7;
+    x5 -= x7;
+    x7 = x8 + x3;
+    x8 -= x3;
+    x3 = x0 + x2;
+    x0 -= x2;
+    x2 = (181 * (x4 + x5) + 128) >> 8;
+    x4 = (181 * (x4 - x5) + 128) >> 8;
+    *out = njClip(((x7 + x1) >> 14) + 128);  out += stride;
+    *out = njClip(((x3 + x2) >> 14) + 128);  out += stride;
+    *out = njClip(((x0 + x4) >> 14) + 128);  out += stride;
+    *out = njClip(((x8 + x6) >> 14) + 128);  out += stride;
+    *out = njClip(((x8 - x6) >> 14) + 128);  out += stride;
+    *out = njClip(((x0 - x4) >> 14) + 128);  out += stride;
+    *out = njClip(((x3 - x2) >> 14) + 128);  out += stride;
+    *out = njClip(((x7 - x1) >> 14) + 128);
+}
+
+// Entropy-coded data: byte stuffing and RST markers are handled here.  Past
+// EOI the stream is padded with 1 bits as in NanoJPEG; running out of bytes
+// before EOI means the scan is cut off.
+static int njShowBits(int bits) {
+    unsigned char newbyte;
+    if (!bits) return 0;
+    while (nj.bufbits < (unsigned int) bits) {
+        if (!nj.size) {
+            if (!nj.eoi) njThrow(INCOMPLETE);
+            nj.buf = (nj.buf << 8) | 0xFF;
+            nj.bufbits += 8;
+            continue;
+        }
+        newbyte = *nj.pos++;
+        nj.size--;
+        nj.bufbits += 8;
+        nj.buf = (nj.buf << 8) | newbyte;
+        if (newbyte == 0xFF) {
+            unsigned char marker;
+            njNeed(1);
+            marker = *nj.pos++;
+            nj.size--;
+            switch (marker) {
+                case 0x00:
+                case 0xFF:
+                    break;
+                case 0xD9:
+                    nj.eoi = 1;
+                    nj.trailing = nj.size;
+                    nj.size = 0;
+                    break;
+                default:
+                    if ((marker & 0xF8) != 0xD0) njThrow(INCORRECT);
+                    nj.buf = (nj.buf << 8) | marker;
+                    nj.bufbits += 8;
+            }
+        }
+    }
+    return (nj.buf >> (nj.bufbits - bits)) & ((1 << bits) - 1);
+}
+
+static void njSkipBits(int bits) {
+    if (nj.bufbits < (unsigned int) bits)
+        (void) njShowBits(bits);
+    nj.bufbits -= bits;
+}
+
+static int njGetBits(int bits) {
+    int res = njShowBits(bits);
+    njSkipBits(bits);
+    return res;
+}
+
+static void njByteAlign(void) {
+    nj.bufbits &= 0xF8;
+}
+
+static void njSkip(int count) {
+    nj.pos += count;
+    nj.size -= count;
+    nj.length -= count;
+}
+
+static unsigned short njDecode16(const unsigned char *pos) {
+    return (pos[0] << 8) | pos[1];
+}
+
+static void njDecodeLength(void) {
+    njNeed(2);
+    nj.length = njDecode16(nj.pos);
+    if (nj.length < 2) njThrow(INCORRECT);
+    njSkip(2);
+}
+
+static void njSkipMarker(void) {
+    njDecodeLength();
+    njNeed(nj.length);
+    njSkip(nj.length);
+}
+
+static void njDecodeSOF(void) {
+    int i, ssxmax = 0, ssymax = 0;
+    nj_component_t* c;
+    if (nj.ncomp) njThrow(INCORRECT);   // one frame per image
+    njDecodeLength();
+    if (nj.length < 9) njThrow(INCORRECT);
+    njNeed(1);
+    if (nj.pos[0] != 8) njThrow(INCORRECT);
+    njNeed(5);
+    nj.height = njDecode16(nj.pos+1);
+    nj.width = njDecode16(nj.pos+3);
+    if (!nj.width || !nj.height) njThrow(INCORRECT);
+    njNeed(6);
+    nj.ncomp = nj.pos[5];
+    njSkip(6);
+    switch (nj.ncomp) {
+        case 1:
+        case 3:
+            break;
+        default:
+            njThrow(INCORRECT);
+    }
+    if (nj.length < (nj.ncomp * 3)) njThrow(INCORRECT);
+    for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
+        njNeed(2);
+        c->cid = nj.pos[0];
+        if (!(c->ssx = nj.pos[1] >> 4)) njThrow(INCORRECT);
+        if (c->ssx & (c->ssx - 1)) njThrow(INCORRECT);  // non-power of two
+        if (!(c->ssy = nj.pos[1] & 15)) njThrow(INCORRECT);
+        if (c->ssy & (c->ssy - 1)) njThrow(INCORRECT);  // non-power of two
+        njNeed(3);
+        if ((c->qtsel = nj.pos[2]) & 0xFC) njThrow(INCORRECT);
+        njSkip(3);
+        nj.qtused |= 1 << c->qtsel;
+        if (c->ssx > ssxmax) ssxmax = c->ssx;
+        if (c->ssy > ssymax) ssymax = c->ssy;
+    }
+    if (nj.ncomp == 1) {
+        c = nj.comp;
+        c->ssx = c->ssy = ssxmax = ssymax = 1;
+    }
+    nj.mbsizex = ssxmax << 3;
+    nj.mbsizey = ssymax << 3;
+    nj.mbwidth = (nj.width + nj.mbsizex - 1) / nj.mbsizex;
+    nj.mbheight = (nj.height + nj.mbsizey - 1) / nj.mbsizey;
+    for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
+        c->width = (nj.width * c->ssx + ssxmax - 1) / ssxmax;
+        c->height = (nj.height * c->ssy + ssymax - 1) / ssymax;
+        c->stride = nj.mbwidth * c->ssx << 3;
+        if (((c->width < 3) && (c->ssx != ssxmax)) || ((c->height < 3) && (c->ssy != ssymax))) njThrow(INCORRECT);
+        // an image too large to hold is one this decoder cannot decode
+        if (!(c->pixels = (unsigned char*) malloc((size_t) c->stride * nj.mbheight * c->ssy << 3))) njThrow(INCORRECT);
+    }
+    njNeed(nj.length);
+    njSkip(nj.length);
+}
+
+static void njDecodeDHT(void) {
+    int codelen, currcnt, remain, spread, i, j;
+    nj_vlc_code_t *vlc;
+    unsigned char counts[16];
+    njDecodeLength();
+    while (nj.length >= 17) {
+        njNeed(1);
+        i = nj.pos[0];
+        if (i & 0xEC) njThrow(INCORRECT);
+        if (i & 0x02) njThrow(INCORRECT);
+        i = (i | (i >> 3)) & 3;  // combined DC/AC + tableid value
+        njNeed(17);
+        nj.vlcavail |= 1 << i;
+        for (codelen = 1;  codelen <= 16;  ++codelen)
+            counts[codelen - 1] = nj.pos[codelen];
+        njSkip(17);
+        vlc = &nj_vlctab[i][0];
+        remain = spread = 65536;
+        for (codelen = 1;  codelen <= 16;  ++codelen) {
+            spread >>= 1;
+            currcnt = counts[codelen - 1];
+            if (!currcnt) continue;
+            if (nj.length < currcnt) njThrow(INCORRECT);
+            remain -= currcnt << (16 - codelen);
+            if (remain < 0) njThrow(INCORRECT);
+            njNeed(currcnt);
+            for (i = 0;  i < currcnt;  ++i) {
+                unsigned char code = nj.pos[i];
+                for (j = spread;  j;  --j) {
+                    vlc->bits = (unsigned char) codelen;
+                    vlc->code = code;
+                    ++vlc;
+                }
+            }
+            njSkip(currcnt);
+        }
+        while (remain--) {
+            vlc->bits = 0;
+            ++vlc;
+        }
+    }
+    if (nj.length) njThrow(INCORRECT);
+}
+
+static void njDecodeDQT(void) {
+    int i;
+    unsigned char *t;
+    njDecodeLength();
+    while (nj.length >= 65) {
+        njNeed(1);
+        i = nj.pos[0];
+        if (i & 0xFC) njThrow(INCORRECT);
+        njNeed(65);
+        nj.qtavail |= 1 << i;
+        t = &nj.qtab[i][0];
+        for (i = 0;  i < 64;  ++i)
+            t[i] = nj.pos[i + 1];
+        njSkip(65);
+    }
+    if (nj.length) njThrow(INCORRECT);
+}
+
+static void njDecodeDRI(void) {
+    njDecodeLength();
+    if (nj.length < 2) njThrow(INCORRECT);
+    njNeed(2);
+    nj.rstinterval = njDecode16(nj.pos);
+    njNeed(nj.length);
+    njSkip(nj.length);
+}
+
+static int njGetVLC(int table, unsigned char* code) {
+    const nj_vlc_code_t* vlc = &nj_vlctab[table][0];
+    int value = njShowBits(16);
+    int bits = (nj.vlcavail >> table & 1) ? vlc[value].bits : 0;
+    if (!bits) njThrow(INCORRECT);
+    njSkipBits(bits);
+    value = vlc[value].code;
+    if (code) *code = (unsigned char) value;
+    bits = value & 15;
+    if (!bits) return 0;
+    value = njGetBits(bits);
+    if (value < (1 << (bits - 1)))
+        value -= (1 << bits) - 1;
+    return value;
+}
+
+static void njDecodeBlock(nj_component_t* c, unsigned char* out) {
+    unsigned char code = 0;
+    int value, coef = 0;
+    memset(nj.block, 0, sizeof(nj.block));
+    c->dcpred += njGetVLC(c->dctabsel, NULL);
+    nj.block[0] = (c->dcpred) * nj.qtab[c->qtsel][0];
+    do {
+        value = njGetVLC(c->actabsel, &code);
+        if (!code) break;  // EOB
+        if (!(code & 0x0F) && (code != 0xF0)) njThrow(INCORRECT);
+        coef += (code >> 4) + 1;
+        if (coef > 63) njThrow(INCORRECT);
+        nj.block[(int) njZZ[coef]] = value * nj.qtab[c->qtsel][coef];
+    } while (coef < 63);
+    for (coef = 0;  coef < 64;  coef += 8)
+        njRowIDCT(&nj.block[coef]);
+    for (coef = 0;  coef < 8;  ++coef)
+        njColIDCT(&nj.block[coef], &out[coef], c->stride);
+}
+
+static void njDecodeScan(void) {
+    int i, mbx, mby, sbx, sby;
+    int rstcount = nj.rstinterval, nextrst = 0;
+    nj_component_t* c;
+    if (!nj.ncomp) njThrow(INCORRECT);   // no frame header yet
+    njDecodeLength();
+    if (nj.length < (4 + 2 * nj.ncomp)) njThrow(INCORRECT);
+    njNeed(1);
+    if (nj.pos[0] != nj.ncomp) njThrow(INCORRECT);
+    njSkip(1);
+    for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
+        njNeed(1);
+        if (nj.pos[0] != c->cid) njThrow(INCORRECT);
+        njNeed(2);
+        if (nj.pos[1] & 0xEE) njThrow(INCORRECT);
+        c->dctabsel = nj.pos[1] >> 4;
+        c->actabsel = (nj.pos[1] & 1) | 2;
+        njSkip(2);
+    }
+    njExpect(0, 0);      // spectral selection 0..63, no successive
+    njExpect(1, 63);     // approximation: baseline only
+    njExpect(2, 0);
+    njNeed(3);
+    njNeed(nj.length);
+    njSkip(nj.length);
+    for (mbx = mby = 0;;) {
+        for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c)
+            for (sby = 0;  sby < c->ssy;  ++sby)
+                for (sbx = 0;  sbx < c->ssx;  ++sbx)
+                    njDecodeBlock(c, &c->pixels[((mby * c->ssy + sby) * c->stride + mbx * c->ssx + sbx) << 3]);
+        if (++mbx >= nj.mbwidth) {
+            mbx = 0;
+            if (++mby >= nj.mbheight) break;
+        }
+        if (nj.rstinterval && !(--rstcount)) {
+            njByteAlign();
+            i = njGetBits(16);
+            if (((i & 0xFFF8) != 0xFFD0) || ((i & 7) != nextrst)) njThrow(INCORRECT);
+            nextrst = (nextrst + 1) & 7;
+            rstcount = nj.rstinterval;
+            for (i = 0;  i < 3;  ++i)
+                nj.comp[i].dcpred = 0;
+        }
+    }
+}
+
+// The scan is followed by EOI, unless the bit reader already consumed it,
+// and EOI ends the stream
+static void njDecodeEOI(void) {
+    if (!nj.eoi) {
+        njExpect(0, 0xFF);
+        njExpect(1, 0xD9);
+        njNeed(2);
+        njSkip(2);
+        nj.trailing = nj.size;
+    }
+    if (nj.trailing) njThrow(INCORRECT);
+}
+
+#define CF4A (-9)
+#define CF4B (111)
+#define CF4C (29)
+#define CF4D (-3)
+#define CF3A (28)
+#define CF3B (109)
+#define CF3C (-9)
+#define CF3X (104)
+#define CF3Y (27)
+#define CF3Z (-3)
+#define CF2A (139)
+#define CF2B (-11)
+#define CF(x) njClip(((x) + 64) >> 7)
+
+static void njUpsampleH(nj_component_t* c) {
+    const int xmax = c->width - 3;
+    unsigned char *out, *lin, *lout;
+    int x, y;
+    out = (unsigned char*) malloc((size_t) (c->width * c->height) << 1);
+    if (!out) njThrow(INCORRECT);
+    lin = c->pixels;
+    lout = out;
+    for (y = c->height;  y;  --y) {
+        lout[0] = CF(CF2A * lin[0] + CF2B * lin[1]);
+        lout[1] = CF(CF3X * lin[0] + CF3Y * lin[1] + CF3Z * lin[2]);
+        lout[2] = CF(CF3A * lin[0] + CF3B * lin[1] + CF3C * lin[2]);
+        for (x = 0;  x < xmax;  ++x) {
+            lout[(x << 1) + 3] = CF(CF4A * lin[x] + CF4B * lin[x + 1] + CF4C * lin[x + 2] + CF4D * lin[x + 3]);
+            lout[(x << 1) + 4] = CF(CF4D * lin[x] + CF4C * lin[x + 1] + CF4B * lin[x + 2] + CF4A * lin[x + 3]);
+        }
+        lin += c->stride;
+        lout += c->width << 1;
+        lout[-3] = CF(CF3A * lin[-1] + CF3B * lin[-2] + CF3C * lin[-3]);
+        lout[-2] = CF(CF3X * lin[-1] + CF3Y * lin[-2] + CF3Z * lin[-3]);
+        lout[-1] = CF(CF2A * lin[-1] + CF2B * lin[-2]);
+    }
+    c->width <<= 1;
+    c->stride = c->width;
+    free(c->pixels);
+    c->pixels = out;
+}
+
+static void njUpsampleV(nj_component_t* c) {
+    const int w = c->width, s1 = c->stride, s2 = s1 + s1;
+    unsigned char *out, *cin, *cout;
+    int x, y;
+    out = (unsigned char*) malloc((size_t) (c->width * c->height) << 1);
+    if (!out) njThrow(INCORRECT);
+    for (x = 0;  x < w;  ++x) {
+        cin = &c->pixels[x];
+        cout = &out[x];
+        *cout = CF(CF2A * cin[0] + CF2B * cin[s1]);  cout += w;
+        *cout = CF(CF3X * cin[0] + CF3Y * cin[s1] + CF3Z * cin[s2]);  cout += w;
+        *cout = CF(CF3A * cin[0] + CF3B * cin[s1] + CF3C * cin[s2]);  cout += w;
+        cin += s1;
+        for (y = c->height - 3;  y;  --y) {
+            *cout = CF(CF4A * cin[-s1] + CF4B * cin[0] + CF4C * cin[s1] + CF4D * cin[s2]);  cout += w;
+            *cout = CF(CF4D * cin[-s1] + CF4C * cin[0] + CF4B * cin[s1] + CF4A * cin[s2]);  cout += w;
+            cin += s1;
+        }
+        cin += s1;
+        *cout = CF(CF3A * cin[0] + CF3B * cin[-s1] + CF3C * cin[-s2]);  cout += w;
+        *cout = CF(CF3X * cin[0] + CF3Y * cin[-s1] + CF3Z * cin[-s2]);  cout += w;
+        *cout = CF(CF2A * cin[0] + CF2B * cin[-s1]);
+    }
+    c->height <<= 1;
+    c->stride = c->width;
+    free(c->pixels);
+    c->pixels = out;
+}
+
+static void njConvert(void) {
+    int i;
+    nj_component_t* c;
+    for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
+        while ((c->width < nj.width) || (c->height < nj.height)) {
+            if (c->width < nj.width) njUpsampleH(c);
+            if (c->height < nj.height) njUpsampleV(c);
+        }
+    }
+    if (nj.ncomp == 3) {
+        // convert to RGB
+        int x, yy;
+        unsigned char *prgb;
+        const unsigned char *py  = nj.comp[0].pixels;
+        const unsigned char *pcb = nj.comp[1].pixels;
+        const unsigned char *pcr = nj.comp[2].pixels;
+        if (!(nj.rgb = prgb = (unsigned char*) malloc((size_t) nj.width * nj.height * 3))) njThrow(INCORRECT);
+        for (yy = nj.height;  yy;  --yy) {
+            for (x = 0;  x < nj.width;  ++x) {
+                int y = py[x] << 8;
+                int cb = pcb[x] - 128;
+                int cr = pcr[x] - 128;
+                *prgb++ = njClip((y            + 359 * cr + 128) >> 8);
+                *prgb++ = njClip((y -  88 * cb - 183 * cr + 128) >> 8);
+                *prgb++ = njClip((y + 454 * cb            + 128) >> 8);
+            }
+            py += nj.comp[0].stride;
+            pcb += nj.comp[1].stride;
+            pcr += nj.comp[2].stride;
+        }
+    }
+}
+
+static void njDone(void) {
+    int i;
+    for (i = 0;  i < 3;  ++i)
+        free(nj.comp[i].pixels);
+    free(nj.rgb);
+}
+
+// Verdict for jpeg[0, size)
+static int njDecode(const unsigned char* jpeg, size_t size) {
+    volatile int verdict;
+    memset(&nj, 0, sizeof(nj));
+    nj.pos = jpeg;
+    nj.size = size;
+    verdict = setjmp(nj_fail);
+    if (verdict) {
+        verdict -= 1;
+    } else {
+        njExpect(0, 0xFF);
+        njExpect(1, 0xD8);
+        njNeed(2);
+        njSkip(2);
+        for (;;) {
+            njExpect(0, 0xFF);
+            njNeed(2);
+            njSkip(2);
+            switch (nj.pos[-1]) {
+                case 0xC0: njDecodeSOF();  continue;
+                case 0xC4: njDecodeDHT();  continue;
+                case 0xDB: njDecodeDQT();  continue;
+                case 0xDD: njDecodeDRI();  continue;
+                case 0xDA: njDecodeScan(); break;
+                case 0xFE: njSkipMarker(); continue;
+                default:
+                    if ((nj.pos[-1] & 0xF0) != 0xE0) njThrow(INCORRECT);
+                    njSkipMarker();
+                    continue;
+            }
+            break;
+        }
+        njDecodeEOI();
+        njConvert();
+        verdict = CORRECT;
+    }
+    njDone();
+    return verdict;
+}
+
+// JPEG files are read whole; anything larger than this is rejected.  Only
+// the one-shot main reads files, so an input it cannot hold ends the process
+#define MAX_INPUT (64 << 20)
+
+FILE* v = 0;
+unsigned char* read_input(size_t* len) {
+    size_t capacity = 1 << 16;
+    unsigned char* bytes = malloc(capacity);
+    unsigned char* grown;
+    size_t n;
+    *len = 0;
+    while (bytes && (n = fread(bytes + *len, 1, capacity - *len, v)) > 0) {
+        *len += n;
+        if (*len == capacity) {
+            if (capacity == MAX_INPUT) {
+                free(bytes);
+                exit(INCORRECT);
+            }
+            capacity *= 2;
+            grown = realloc(bytes, capacity);
+            if (!grown) {
+                free(bytes);
+            }
+            bytes = grown;
+        }
+    }
+    if (!bytes) {
+        exit(INCORRECT);
+    }
+    return bytes;
+}
+
+// Persistent mode (--persistent [N]): one process checks N inputs (default
+// 1000) and exits, so whatever the decoder leaks is bounded.  Each input
+// arrives on stdin as a 4-byte little-endian length and the bytes; its
+// verdict, the exit code a fresh process would have returned, is written as
+// one byte to file descriptor 3.
+// A length with the top bit set asks for the viable next bytes of the
+// input instead: a 32-byte bitmap of the bytes b for which input + b is not
+// INCORRECT (verdict 0 or 255).  The bitmap is followed by the number of
+// parses run for it, 4 bytes little-endian (see write_parses).
+int read_record(unsigned char** data, size_t* len, int* next) {
+    unsigned char header[4];
+    if (fread(header, 1, 4, stdin) != 4) {
+        return 0;
+    }
+    *next = header[3] >> 7;
+    *len = header[0] | header[1] << 8 | header[2] << 16 | (size_t)(header[3] & 0x7f) << 24;
+    *data = malloc(*len + 1);
+    if (*data != NULL && fread(*data, 1, *len, stdin) == *len) {
+        return 1;
+    }
+    free(*data);
+    *data = NULL;
+    return 0;
+}
+
+// Sends the number of parses a next-byte answer took
+void write_parses(FILE* out, unsigned long parses) {
+    for (int i = 0; i < 4; i++) {
+        fputc((int)(parses >> (8 * i) & 0xff), out);
+    }
+}
+
+int persistent_main(int iterations) {
+    FILE* verdicts = fdopen(3, "w");
+    if (!verdicts) {
+        fprintf(stderr, "Persistent mode needs file descriptor 3 for the verdicts\n");
+        exit(2);
+    }
+    for (int n = 0; n < iterations; n++) {
+        unsigned char* data = NULL;
+        size_t len = 0;
+        int next = 0;
+        if (!read_record(&data, &len, &next)) {
+            break;
+        }
+        if (next) {
+            unsigned char viable[32] = { 0 };
+            for (int b = 0; b < 256; b++) {
+                data[len] = (unsigned char)b;
+                int verdict = njDecode(data, len + 1);
+                if (verdict == CORRECT || verdict == INCOMPLETE) {
+                    viable[b / 8] |= 1 << (b % 8);
+                }
+            }
+            fwrite(viable, 1, 32, verdicts);
+            write_parses(verdicts, 256);
+        } else {
+            fputc(njDecode(data, len), verdicts);
+        }
+        free(data);
+        fflush(verdicts);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--persistent") == 0) {
+        return persistent_main(argc > 2 ? atoi(argv[2]) : 1000);
+    }
+    if (argc > 1) {
+        // Try to open as a file, if fails, try as a file descriptor
+        v = fopen(argv[1], "rb");
+        if (!v) {
+            if (strncmp(argv[1], "/dev/fd/", 8) == 0) {
+                int fd = atoi(argv[1] + 8);
+                if (fd > 0) {
+                    v = fdopen(fd, "rb");
+                }
+            }
+        }
+        if (!v) {
+            fprintf(stderr, "Failed to open input file: %s\n", argv[1]);
+            exit(2);
+        }
+    } else {
+        v = stdin;
+    }
+    size_t len = 0;
+    unsigned char* bytes = read_input(&len);
+    if (argc > 1) {
+        fclose(v);
+    }
+    int verdict = njDecode(bytes, len);
+    free(bytes);
+    return verdict;
+}
@@ -6,9 +6,22 @@
 //   255 lexer reached EOF inside token  OR  parser offending token == EOF
 //   2   usage / I‑O error
 //
+// With --persistent [N] it checks a stream of inputs instead (see
+// persistentMain), re-lexing only around the bytes that changed.
+//
+// The v / vt / vn / f lines that make up most of a mesh are checked by
+// hand first (see collapseMeshLines); --antlr-only leaves them to ANTLR.
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "antlr4-runtime.h"
 #include "WavefrontOBJLexer.h"
@@ -46,13 +59,186 @@ public:
     }
 };
 
+// ---------------------------------------------------------------
+// Fast path for the mesh data.  A v, vt, vn or f line is lexed as a
+// keyword and blank-separated INTEGER / DECIMAL / INTEGER_PAIR /
+// INTEGER_TRIPLET tokens, so it can be checked here byte by byte.  Each
+// run of valid ones, with the blank lines between them, is replaced by
+// the statement "v 0 0 0": the parser ends up in the same state after
+// either (and an error, in a free-form block, still comes at the first
+// token), so the verdict is the same and ANTLR only sees the other lines.
+// A run starts only after a line without '#' or '\', since a comment or a
+// line continuation would join the line to the one before it.
+// ---------------------------------------------------------------
+
+// Skips -?[0-9]+ at p
+bool skipInteger(const char*& p, const char* end) {
+    if (p < end && *p == '-') p++;
+    const char* digits = p;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    return p > digits;
+}
+
+// [p, end) is one INTEGER or DECIMAL token
+bool isDecimal(const char* p, const char* end) {
+    if (!skipInteger(p, end)) return false;
+    if (p < end && *p == '.')
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {}
+    return p == end;
+}
+
+// [p, end) is one INTEGER, INTEGER_PAIR or INTEGER_TRIPLET token
+bool isIndex(const char* p, const char* end) {
+    if (!skipInteger(p, end)) return false;
+    if (p == end) return true;
+    if (*p++ != '/') return false;
+    if (p < end && *p == '/') p++;
+    else if (!skipInteger(p, end)) return false;
+    else if (p == end) return true;
+    else if (*p++ != '/') return false;
+    return skipInteger(p, end) && p == end;
+}
+
+// [p, end), a line without its NL, is a valid vertex, vertex_texture,
+// vertex_normal or faces statement
+bool isMeshLine(const char* p, const char* end) {
+    for (const char* q = p; q < end; q++) {
+        unsigned char c = *q;
+        if ((c < 0x20 && c != '\t') || c >= 0x7f || c == '#' || c == '\\') return false;
+    }
+    const char *word, *stop;
+    auto nextWord = [&]() {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        for (word = p; p < end && *p != ' ' && *p != '\t'; p++) {}
+        stop = p;
+        return word < stop;
+    };
+    if (!nextWord()) return false;
+    std::string_view keyword(word, stop - word);
+    size_t least, most;
+    if (keyword == "v")       least = 3, most = 4;
+    else if (keyword == "vt") least = 1, most = 3;
+    else if (keyword == "vn") least = 3, most = 3;
+    else if (keyword == "f")  least = 1, most = SIZE_MAX;
+    else return false;
+    bool face = keyword == "f";
+    size_t count = 0;
+    for (; nextWord(); count++)
+        if (!(face ? isIndex(word, stop) : isDecimal(word, stop))) return false;
+    return count >= least && count <= most;
+}
+
+// Where collapseLines() stopped
+struct Collapsed {
+    std::string out;                // the text before copied, collapsed
+    size_t copied = 0;              // text before this is in out (or dropped)
+    size_t line = 0;                // first line not gone over yet
+    bool joinable = false;          // the line before may carry into this one
+    bool inRun = false;
+};
+
+// Replaces each run of valid mesh lines in text from c.line on by "v 0 0 0".
+// A line is settled by the text up to its end, so without whole it stops
+// before the last line, the only one that bytes appended to text change
+// (a final CR too, since an LF after it would join it).
+void collapseLines(const std::string& text, Collapsed& c, bool whole) {
+    const char* begin = text.data();
+    const char* p = begin + c.line;
+    const char* end = begin + text.size();
+    while (p < end) {
+        const char* eol = p;
+        bool blank = true, carries = false;
+        for (; eol < end && *eol != '\n' && *eol != '\r'; eol++) {
+            blank &= *eol == ' ' || *eol == '\t';
+            carries |= *eol == '#' || *eol == '\\';
+        }
+        if (!whole && (eol == end || (*eol == '\r' && eol + 1 == end))) break;
+        if (c.inRun && blank) {
+            // NLs between two statements of the run
+        } else if (!c.joinable && isMeshLine(p, eol)) {
+            if (!c.inRun) {
+                c.out.append(begin + c.copied, p);
+                c.out += "v 0 0 0";
+                c.inRun = true;
+            }
+            c.copied = eol - begin;
+        } else {
+            c.inRun = false;
+        }
+        c.joinable = carries;
+        p = eol;
+        if (p < end) p += (*p == '\r' && p + 1 < end && p[1] == '\n') ? 2 : 1;
+    }
+    c.line = p - begin;
+}
+
+// text collapsed, going on from c (c itself is left as it was)
+std::string collapseRest(const std::string& text, Collapsed c) {
+    collapseLines(text, c, true);
+    c.out.append(text, c.copied, std::string::npos);
+    return std::move(c.out);
+}
+
+// text with each run of valid mesh lines replaced by "v 0 0 0"
+std::string collapseMeshLines(const std::string& text) {
+    return collapseRest(text, Collapsed());
+}
+
 #include <fcntl.h>
 #include <unistd.h>
 
+#include "incremental_relex.h"
+
+// ---------------------------------------------------------------
+// Persistent mode (--persistent [N]): see incremental_relex.h
+// ---------------------------------------------------------------
+typedef IncrementalValidator<WavefrontOBJLexer, WavefrontOBJParser, ErrorFlags> Validator;
+
+int persistentMain(int iterations, bool fast) {
+    FILE* verdicts = fdopen(3, "w");
+    if (!verdicts) {
+        std::cerr << "Persistent mode needs file descriptor 3 for the verdicts\n";
+        return 2;
+    }
+    Validator validator([](WavefrontOBJParser& parser) { parser.start_(); });
+    std::string data;
+    for (int n = 0; n < iterations; n++) {
+        bool next = false;
+        if (!readRecord(data, next)) break;
+        if (next) {
+            // The lines before the last are collapsed once for all 256 bytes
+            unsigned char viable[32] = { 0 };
+            Collapsed head;
+            if (fast) collapseLines(data, head, false);
+            data.push_back('\0');
+            for (int b = 0; b < 256; b++) {
+                data.back() = static_cast<char>(b);
+                unsigned char verdict = validator.check(fast ? collapseRest(data, head) : data);
+                if (verdict == 0 || verdict == 255) viable[b / 8] |= 1 << (b % 8);
+            }
+            fwrite(viable, 1, 32, verdicts);
+            writeParses(verdicts, 256);
+        } else {
+            fputc(validator.check(fast ? collapseMeshLines(data) : data), verdicts);
+        }
+        fflush(verdicts);
+    }
+    return 0;
+}
+
 int main(int argc, const char* argv[]) {
     /* ---------- 0. file open ------------------------------------- */
+    const char* program = argv[0];
+    bool fast = true;
+    if (argc > 1 && strcmp(argv[1], "--antlr-only") == 0) {
+        fast = false;
+        argv++, argc--;
+    }
+    if (argc > 1 && strcmp(argv[1], "--persistent") == 0) {
+        return persistentMain(argc > 2 ? atoi(argv[2]) : 1000, fast);
+    }
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <file.obj>\n";
+        std::cerr << "Usage: " << program << " [--antlr-only] <file.obj>\n";
         return 2;
     }
 
@@ -79,7 +265,8 @@ int main(int argc, const char* argv[]) {
     }
 
     /* ---------- 1. ANTLR setup ----------------------------------- */
-    antlr4::ANTLRInputStream  input(*in_ptr);
+    std::string text((std::istreambuf_iterator<char>(*in_ptr)), std::istreambuf_iterator<char>());
+    antlr4::ANTLRInputStream  input(fast ? collapseMeshLines(text) : text);
     WavefrontOBJLexer                  lexer(&input);
     antlr4::CommonTokenStream tokens(&lexer);
     WavefrontOBJParser                 parser(&tokens);
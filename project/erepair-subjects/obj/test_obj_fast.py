@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+Differential test: obj_parser with its mesh-line fast path vs. obj_parser --antlr-only.
+
+main.cpp checks v / vt / vn / f lines by hand and hands only the other lines
+to ANTLR (collapseMeshLines); both paths must return the same 0 / 1 / 255
+verdict for every input. With --timing the seed files are also timed both ways.
+
+Inputs: the seed files in original_files/obj_data, the mutated texts in
+mutated_files/*_obj.db, and random byte-level mutations of the seeds.
+
+Usage:
+    python3 test_obj_fast.py [--parser build/obj_parser] [--random N] [--seed S] [--timing]
+"""
+import argparse
+import glob
+import os
+import random
+import sqlite3
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.abspath(os.path.join(HERE, "..", "..", ".."))
+
+
+def verdict(command, data):
+    with tempfile.NamedTemporaryFile(suffix=".obj", delete=False) as f:
+        f.write(data)
+        path = f.name
+    try:
+        rc = subprocess.run(command + [path], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL).returncode
+    finally:
+        os.remove(path)
+    # a crashed validator (e.g. illegal UTF-8) counts as INCORRECT, as in erepair
+    return rc if rc in (0, 1, 255) else 1
+
+
+def seeds():
+    result = []
+    for path in sorted(glob.glob(os.path.join(ROOT, "original_files", "obj_data", "*.obj"))):
+        with open(path, "rb") as f:
+            result.append(f.read())
+    return result
+
+
+def corpus(seed_files, num_random, rng):
+    yield from seed_files
+    for db in sorted(glob.glob(os.path.join(ROOT, "mutated_files", "*_obj.db"))):
+        conn = sqlite3.connect(db)
+        table = "mutations_triple" if db.endswith("triple_obj.db") else "mutations"
+        for (text,) in conn.execute(f"SELECT mutated_text FROM {table}"):
+            if text is not None:
+                yield text.encode("utf-8", "surrogateescape")
+        conn.close()
+    alphabet = b"vtnf/-.0123456789#\\\n\r\t gcurvend\x80"
+    # short token soups hit the corners of the fast path: numbers the lexer
+    # splits differently, comments and line continuations that join a mesh
+    # line to the line before, mesh lines inside a free-form block
+    fragments = [b"v", b"vt", b"vn", b"f", b" ", b"\t", b"1", b"-2", b"3.", b".5", b"1e5", b"1/2", b"1//3",
+                 b"1/2/3", b"/", b"-", b"\n", b"\r", b"\r\n", b"#", b"\\", b"\\\n", b"g a", b"o x",
+                 b"curv 0 1 2 3", b"end", b"bmat u", b"parm u 1 2", b"s 1", b"usemtl m", b"\xc3\xa9"]
+    for i in range(num_random):
+        if i % 3 == 2:
+            yield b"".join(rng.choice(fragments) for _ in range(rng.randint(1, 20)))
+            continue
+        data = bytearray(rng.choice(seed_files)) if seed_files else bytearray()
+        for _ in range(rng.randint(1, 3)):
+            pos = rng.randint(0, len(data))
+            op = rng.randint(0, 3)
+            if op == 0 and pos < len(data):
+                del data[pos]
+            elif op == 1:
+                data[pos:pos] = bytes([rng.choice(alphabet)])
+            elif op == 2 and pos < len(data):
+                data[pos] = rng.choice(alphabet)
+            else:
+                data = data[:pos]   # truncation
+        yield bytes(data)
+
+
+def timing(parser, seed_files):
+    for label, command in (("antlr-only", [parser, "--antlr-only"]), ("fast path", [parser])):
+        start = time.perf_counter()
+        for data in seed_files:
+            verdict(command, data)
+        print(f"{label:>10}: {time.perf_counter() - start:.2f}s for {len(seed_files)} seed files")
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--parser", default=os.path.join(HERE, "build", "obj_parser"))
+    ap.add_argument("--random", type=int, default=2000)
+    ap.add_argument("--seed", type=int, default=0)
+    ap.add_argument("--timing", action="store_true")
+    args = ap.parse_args()
+
+    if not os.path.exists(args.parser):
+        print(f"[ERROR] validator not found: {args.parser}")
+        return 2
+
+    seed_files = seeds()
+    total = 0
+    mismatches = 0
+    for data in corpus(seed_files, args.random, random.Random(args.seed)):
+        total += 1
+        want = verdict([args.parser, "--antlr-only"], data)
+        got = verdict([args.parser], data)
+        if want != got:
+            mismatches += 1
+            if mismatches <= 10:
+                print(f"[MISMATCH] antlr-only={want} fast={got} input={data[:200]!r}")
+    print(f"{total} inputs, {mismatches} mismatches")
+    if args.timing:
+        timing(args.parser, seed_files)
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
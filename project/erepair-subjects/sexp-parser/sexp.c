@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <setjmp.h>
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-label"
@@ -14,6 +15,17 @@ int my_fgetc(FILE* stream) {
     return c;
 }
 
+// The reader reports its verdict by exiting the process.  In persistent mode
+// the verdict unwinds to the per-input driver through this jump buffer
+// instead.
+jmp_buf *verdict_env = NULL;
+void verdict_exit(int code) {
+    if (verdict_env != NULL) {
+        longjmp(*verdict_env, (code & 0xff) + 1);
+    }
+    exit(code);
+}
+
 
 /*
  * bool
@@ -70,7 +82,7 @@ const char *symbol_name(symbol_t *symbol)
 sexp_t *create_symbol(const char *name)
 {
     symbol_t *symbol = (symbol_t *)malloc(sizeof(symbol_t));
-    if (!symbol) exit(-1);
+    if (!symbol) verdict_exit(-1);
 
     symbol->tt = TYPE_SYMBOL;
     symbol->name = strdup(name);
@@ -112,7 +124,7 @@ const char *string_str(string_t *string)
 sexp_t *create_string(const char *str)
 {
     string_t *string = (string_t *)malloc(sizeof(string_t));
-    if (!string) exit(-1);
+    if (!string) verdict_exit(-1);
 
     string->tt = TYPE_STRING;
     string->str = strdup(str);
@@ -155,7 +167,7 @@ int integer_value(integer_t *integer)
 sexp_t *create_integer(const int value)
 {
     integer_t *integer = (integer_t *)malloc(sizeof(integer_t));
-    if (!integer) exit(-1);
+    if (!integer) verdict_exit(-1);
 
     integer->tt = TYPE_INTEGER;
     integer->value = value;
@@ -190,7 +202,7 @@ bool is_nil(sexp_t *sexp)
 sexp_t *create_nil()
 {
     nil_t *nil = (nil_t *)malloc(sizeof(nil_t));
-    if (!nil) exit(-1);
+    if (!nil) verdict_exit(-1);
 
     nil->tt = TYPE_NIL;
 
@@ -236,7 +248,7 @@ sexp_t *pair_cdr(pair_t *pair)
 sexp_t *create_pair(sexp_t *car, sexp_t *cdr)
 {
     pair_t *pair = (pair_t *)malloc(sizeof(pair_t));
-    if (!pair) exit(-1);
+    if (!pair) verdict_exit(-1);
 
     pair->tt = TYPE_PAIR;
     pair->car = car;
@@ -295,7 +307,7 @@ void destroy_sexp(sexp_t *sexp)
         return;
     default:
         fprintf(stderr, "Invalid S-expression.\n");
-        exit(-1);
+        verdict_exit(-1);
     }
 }
 
@@ -319,7 +331,7 @@ void print_sexp(sexp_t *sexp)
         return;
     default:
         fprintf(stderr, "Invalid S-expression.\n");
-        exit(-1);
+        verdict_exit(-1);
     }
 }
 
@@ -373,7 +385,7 @@ void nreverse(sexp_t **psexp)
     while(!is_nil(current)) {
         if (!is_pair(current)) {
             fprintf(stderr, "Not list.");
-            exit(-1);
+            verdict_exit(-1);
         }
         next = ((pair_t *)current)->cdr;
         ((pair_t *)current)->cdr = prev;
@@ -389,11 +401,11 @@ void nreverse(sexp_t **psexp)
 
 #define INCORRECT(_msg) { \
         fprintf(stderr, "%s\n", _msg);\
-        exit(EXIT_INCORRECT); \
+        verdict_exit(EXIT_INCORRECT); \
     }
 #define INCOMPLETE(_msg) { \
         fprintf(stderr, "%s\n", _msg);\
-        exit(EXIT_INCOMPLETE); \
+        verdict_exit(EXIT_INCOMPLETE); \
     }
 
 #define END_OF_FILE         INCOMPLETE("End of file.")
@@ -414,7 +426,7 @@ sexp_t *read_string(FILE *fp, int c)
         _buf[_i++] = _c; \
         if (_i == 256) { \
             fprintf(stderr, "Too long string: %s...\n", _buf); \
-            exit(-1); \
+            verdict_exit(-1); \
         } \
     } while(0)
 
@@ -501,7 +513,7 @@ sexp_t *read(FILE *fp, bool inRoot)
         _buf[_i++] = _c; \
         if (_i == 256) { \
             fprintf(stderr, "Too long symbol: %s...\n", _buf); \
-            exit(-1); \
+            verdict_exit(-1); \
         } \
     } while(0)
 
@@ -657,7 +669,114 @@ step10:
 // Added the infrastructure from our modified cJSON version:
 FILE* v = 0;
 
+// Reads the S-expressions of v up to its end
+void read_sexps() {
+    bool hasReadSexp = false;
+    sexp_t * sexp = NULL;
+
+    while (!hasReadSexp || sexp != NULL){
+        sexp = read(v, true);
+        if (sexp == NULL){
+            if (!hasReadSexp){
+                END_OF_FILE;
+            }
+            continue;
+        } else {
+            print_sexp(sexp);
+            printf("\n");
+            hasReadSexp = true;
+            destroy_sexp(sexp);
+            sexp = NULL;
+        }
+    }
+}
+
+// Persistent mode (--persistent [N]): one process checks N inputs (default
+// 1000) and exits, so whatever the reader leaks is bounded.  Each input
+// arrives on stdin as a 4-byte little-endian length and the bytes; its
+// verdict, the exit code a fresh process would have returned, is written as
+// one byte to file descriptor 3.
+// A length with the top bit set asks for the viable next bytes of the
+// input instead: a 32-byte bitmap of the bytes b for which input + b is not
+// INCORRECT (verdict 0 or 255).  The bitmap is followed by the number of
+// parses run for it, 4 bytes little-endian (see write_parses).
+int read_record(char** data, size_t* len, int* next) {
+    unsigned char header[4];
+    if (fread(header, 1, 4, stdin) != 4) {
+        return 0;
+    }
+    *next = header[3] >> 7;
+    *len = header[0] | header[1] << 8 | header[2] << 16 | (size_t)(header[3] & 0x7f) << 24;
+    *data = malloc(*len + 2);
+    if (*data != NULL && fread(*data, 1, *len, stdin) == *len) {
+        return 1;
+    }
+    free(*data);
+    *data = NULL;
+    return 0;
+}
+
+// Sends the number of parses a next-byte answer took
+void write_parses(FILE* out, unsigned long parses) {
+    for (int i = 0; i < 4; i++) {
+        fputc((int)(parses >> (8 * i) & 0xff), out);
+    }
+}
+
+// Verdict for one input, as a fresh process would exit with it
+unsigned char check_record(char* data, size_t len) {
+    v = fmemopen(data, len, "r");
+    jmp_buf env;
+    int jumped;
+    unsigned char verdict;
+    verdict_env = &env;
+    jumped = setjmp(env);
+    if (!jumped) {
+        read_sexps();
+    }
+    verdict = jumped ? jumped - 1 : 0;   // set after setjmp: not clobbered
+    verdict_env = NULL;
+    fclose(v);
+    return verdict;
+}
+
+int persistent_main(int iterations) {
+    FILE* verdicts = fdopen(3, "w");
+    if (!verdicts) {
+        fprintf(stderr, "Persistent mode needs file descriptor 3 for the verdicts\n");
+        exit(2);
+    }
+    for (int n = 0; n < iterations; n++) {
+        char* data = NULL;
+        size_t len = 0;
+        int next = 0;
+        if (!read_record(&data, &len, &next)) {
+            break;
+        }
+        if (next) {
+            unsigned char viable[32] = { 0 };
+            for (int b = 0; b < 256; b++) {
+                data[len] = (char)b;
+                unsigned char verdict = check_record(data, len + 1);
+                if (verdict == 0 || verdict == 255) {
+                    viable[b / 8] |= 1 << (b % 8);
+                }
+            }
+            fwrite(viable, 1, 32, verdicts);
+            write_parses(verdicts, 256);
+        } else {
+            fputc(check_record(data, len), verdicts);
+        }
+        free(data);
+        fflush(verdicts);
+    }
+    return 0;
+}
+
 int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--persistent") == 0) {
+        return persistent_main(argc > 2 ? atoi(argv[2]) : 1000);
+    }
     if (argc > 1) {
         // Try to open as a file, if fails, try as a file descriptor
         v = fopen(argv[1], "r");
@@ -677,26 +796,7 @@ int main(int argc, char** argv) {
         v = stdin;
     }
 
-    bool hasReadSexp = false;
-    sexp_t * sexp = NULL;
-
-    while (!hasReadSexp || sexp != NULL){
-        sexp = read(v, true);
-        if (sexp == NULL){
-            if (!hasReadSexp){
-                END_OF_FILE;
-            }
-            continue;
-        } else {
-            print_sexp(sexp);
-            printf("\n");
-            hasReadSexp = true;
-            destroy_sexp(sexp);
-            sexp = NULL;
-        }
-    }
-
-    sexp = NULL;
+    read_sexps();
 
     fclose(v);
 
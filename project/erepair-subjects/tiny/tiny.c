@@ -6,24 +6,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <setjmp.h>
 char* buffer = 0;
 int buffer_i = 0;
 int eof = EOF;
-#include "tokens.h"
-
-struct Trie* head = 0;
-void init_tri() {
-    head = getNewTrieNode();
-    insert(head, "do");
-    insert(head, "if");
-    insert(head, "else");
-    insert(head, "while");
-}
+#include "tokens.h"   // search_keyword() for do, if, else, while; see the Makefile
 
 int last_search = -1;
 int check_token(char* str) {
     last_search = buffer_i - strlen(str);
-    return search(head, str);
+    return search_keyword(str);
 }
 /*
  * This is a compiler for the Tiny-C language.  Tiny-C is a
@@ -88,14 +80,23 @@ int sym;
 int int_val;
 char id_name[100];
 
+/* The parser reports its verdict by exiting the process.  In persistent mode
+   the verdict unwinds to the per-input driver through this jump buffer
+   instead. */
+jmp_buf *verdict_env = NULL;
+void verdict_exit(int code) {
+  if (verdict_env != NULL) longjmp(*verdict_env, (code & 0xff) + 1);
+  exit(code);
+}
+
 void syntax_error_ch() {
-  exit(1);
+  verdict_exit(1);
 }
 
 void syntax_error() {
-  exit(1);
+  verdict_exit(1);
 }
-void eof_error() { /*fprintf(stderr, "EOF error\n");*/ exit(-1); }
+void eof_error() { /*fprintf(stderr, "EOF error\n");*/ verdict_exit(-1); }
 void next_ch() {
   /*ch = getc(v);*/
   ch = buffer[buffer_i++];
@@ -321,7 +322,7 @@ char* read_input() {
     int c = 0;
     while((c = fgetc(v)) != EOF){
         if (counter == 1000) {
-            exit(1);
+            verdict_exit(1);
         }
         chars[counter++] = c;
     }
@@ -329,12 +330,135 @@ char* read_input() {
     return chars;
 }
 
+/* Persistent mode (--persistent [N]): one process checks N inputs (default
+   1000) and exits, so whatever the parser leaks is bounded.  Each input
+   arrives on stdin as a 4-byte little-endian length and the bytes; its
+   verdict, the exit code a fresh process would have returned, is written
+   as one byte to file descriptor 3.  Globals are reset before every input.
+   A length with the top bit set asks for the viable next bytes of the
+   input instead: a 32-byte bitmap of the bytes b for which input + b is
+   not INCORRECT (verdict 0 or 255), followed by the number of parses run
+   for it, 4 bytes little-endian. */
+int read_record(char** data, size_t* len, int* next) {
+  unsigned char header[4];
+  if (fread(header, 1, 4, stdin) != 4) return 0;
+  *next = header[3] >> 7;
+  *len = header[0] | header[1] << 8 | header[2] << 16 | (size_t)(header[3] & 0x7f) << 24;
+  *data = malloc(*len + 2);
+  if (*data != NULL && fread(*data, 1, *len, stdin) == *len) return 1;
+  free(*data);
+  *data = NULL;
+  return 0;
+}
+
+/* Verdict for one input, as a fresh process would exit with it */
+unsigned char check_record(char* data, size_t len) {
+  v = fmemopen(data, len, "r");
+  buffer = NULL;
+  buffer_i = 0;
+  ch = ' ';
+  here = object;
+  jmp_buf env;
+  int jumped;
+  unsigned char verdict;
+  verdict_env = &env;
+  jumped = setjmp(env);
+  if (!jumped) {
+    buffer = read_input();
+    c(program());
+  }
+  verdict = jumped ? jumped - 1 : 0;   /* set after setjmp: not clobbered */
+  verdict_env = NULL;
+  fclose(v);
+  free(buffer);
+  return verdict;
+}
+
+/* Sends the number of parses a next-byte answer took */
+void write_parses(FILE* out, unsigned long parses) {
+  for (int i = 0; i < 4; i++) fputc((int)(parses >> (8 * i) & 0xff), out);
+}
+
+/* Class of b as the last byte of an input whose trailing [a-z_] run is
+   word[0, word_len): bytes of one class give the same verdict.  NUL (it
+   ends the input), blanks, digits and the bytes no token starts with are
+   classes, as is each punctuator.  Letters are split by the keyword that
+   word spells with them (the same for all when there is no word: a
+   one-letter ID); '_' continues a word into no keyword. */
+int byte_class(const char* word, size_t word_len, int b) {
+  if (b == 0 || strchr("{}()+-<;=", b) != NULL) return b;
+  if (b == ' ' || b == '\n') return 256;
+  if (b >= '0' && b <= '9') return 257;
+  if ((b >= 'a' && b <= 'z') || (b == '_' && word_len > 0)) {
+    char id[8];
+    int k = 0;
+    if (b != '_' && word_len + 1 < sizeof(id)) {
+      memcpy(id, word, word_len);
+      id[word_len] = (char)b;
+      id[word_len + 1] = '\0';
+      while (words[k] != NULL && strcmp(words[k], id) != 0) k++;
+    } else {
+      while (words[k] != NULL) k++;
+    }
+    return 258 + k;
+  }
+  return 263;
+}
+
+/* Next-byte answer for data[0, len): one parse per byte class.  Returns the
+   number of parses. */
+unsigned long next_bytes(char* data, size_t len, unsigned char viable[32]) {
+  int verdict[264];
+  unsigned long parses = 0;
+  size_t word = len;
+  while (word > 0 && ((data[word - 1] >= 'a' && data[word - 1] <= 'z') || data[word - 1] == '_')) word--;
+  for (int k = 0; k < 264; k++) verdict[k] = -1;
+  for (int b = 0; b < 256; b++) {
+    int k = byte_class(data + word, len - word, b);
+    if (verdict[k] < 0) {
+      data[len] = (char)b;
+      verdict[k] = check_record(data, len + 1);
+      parses++;
+    }
+    if (verdict[k] == 0 || verdict[k] == 255) viable[b / 8] |= 1 << (b % 8);
+  }
+  return parses;
+}
+
+int persistent_main(int iterations) {
+  FILE* verdicts = fdopen(3, "w");
+  if (!verdicts) {
+    fprintf(stderr, "Persistent mode needs file descriptor 3 for the verdicts\n");
+    exit(2);
+  }
+  for (int n = 0; n < iterations; n++) {
+    char* data = NULL;
+    size_t len = 0;
+    int next = 0;
+    if (!read_record(&data, &len, &next)) break;
+    if (next) {
+      unsigned char viable[32] = { 0 };
+      unsigned long parses = next_bytes(data, len, viable);
+      fwrite(viable, 1, 32, verdicts);
+      write_parses(verdicts, parses);
+    } else {
+      fputc(check_record(data, len), verdicts);
+    }
+    free(data);
+    fflush(verdicts);
+  }
+  return 0;
+}
+
 /* Main program. */
 
 int main(int argc, char** argv)
 { int i;
   /*char buffer[1024];
   fgets(buffer, 1024, stdin);*/
+  if (argc > 1 && strcmp(argv[1], "--persistent") == 0) {
+    return persistent_main(argc > 2 ? atoi(argv[2]) : 1000);
+  }
   if (argc > 1) {
     // Try to open as a file, if fails, try as a file descriptor
     v = fopen(argv[1], "r");
@@ -354,7 +478,6 @@ int main(int argc, char** argv)
     v = stdin;
   }
   buffer = read_input();
-  init_tri();
   c(program());
 
   for (i=0; i<26; i++)
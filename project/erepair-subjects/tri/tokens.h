@@ -0,0 +1,237 @@
+// tokens.h -- keyword recognizer for true false null; generated by
+// gen_keywords.py --next true false null, do not edit.
+#ifndef TOKENS_H
+#define TOKENS_H
+
+#define VALID 0
+#define INCOMPLETE -1
+#define INCORRECT 1
+
+static int search_keyword(const char* str) {
+    switch (str[0]) {
+    case 'f':
+        switch (str[1]) {
+        case 'a':
+            switch (str[2]) {
+            case 'l':
+                switch (str[3]) {
+                case 's':
+                    switch (str[4]) {
+                    case 'e':
+                        switch (str[5]) {
+                        case '\0':
+                            return VALID;
+                        default:
+                            return INCORRECT;
+                        }
+                    case '\0':
+                        return INCOMPLETE;
+                    default:
+                        return INCORRECT;
+                    }
+                case '\0':
+                    return INCOMPLETE;
+                default:
+                    return INCORRECT;
+                }
+            case '\0':
+                return INCOMPLETE;
+            default:
+                return INCORRECT;
+            }
+        case '\0':
+            return INCOMPLETE;
+        default:
+            return INCORRECT;
+        }
+    case 'n':
+        switch (str[1]) {
+        case 'u':
+            switch (str[2]) {
+            case 'l':
+                switch (str[3]) {
+                case 'l':
+                    switch (str[4]) {
+                    case '\0':
+                        return VALID;
+                    default:
+                        return INCORRECT;
+                    }
+                case '\0':
+                    return INCOMPLETE;
+                default:
+                    return INCORRECT;
+                }
+            case '\0':
+                return INCOMPLETE;
+            default:
+                return INCORRECT;
+            }
+        case '\0':
+            return INCOMPLETE;
+        default:
+            return INCORRECT;
+        }
+    case 't':
+        switch (str[1]) {
+        case 'r':
+            switch (str[2]) {
+            case 'u':
+                switch (str[3]) {
+                case 'e':
+                    switch (str[4]) {
+                    case '\0':
+                        return VALID;
+                    default:
+                        return INCORRECT;
+                    }
+                case '\0':
+                    return INCOMPLETE;
+                default:
+                    return INCORRECT;
+                }
+            case '\0':
+                return INCOMPLETE;
+            default:
+                return INCORRECT;
+            }
+        case '\0':
+            return INCOMPLETE;
+        default:
+            return INCORRECT;
+        }
+    case '\0':
+        return INCOMPLETE;
+    default:
+        return INCORRECT;
+    }
+}
+
+static void next_keyword_bytes(const char* str, unsigned char viable[32]) {
+    switch (str[0]) {
+    case 'f':
+        switch (str[1]) {
+        case 'a':
+            switch (str[2]) {
+            case 'l':
+                switch (str[3]) {
+                case 's':
+                    switch (str[4]) {
+                    case 'e':
+                        switch (str[5]) {
+                        case '\0':
+                            viable[0] |= 1;   /* NUL */
+                            return;
+                        default:
+                            return;
+                        }
+                    case '\0':
+                        viable[0] |= 1;   /* NUL */
+                        viable[12] |= 32;   /* 'e' */
+                        return;
+                    default:
+                        return;
+                    }
+                case '\0':
+                    viable[0] |= 1;   /* NUL */
+                    viable[14] |= 8;   /* 's' */
+                    return;
+                default:
+                    return;
+                }
+            case '\0':
+                viable[0] |= 1;   /* NUL */
+                viable[13] |= 16;   /* 'l' */
+                return;
+            default:
+                return;
+            }
+        case '\0':
+            viable[0] |= 1;   /* NUL */
+            viable[12] |= 2;   /* 'a' */
+            return;
+        default:
+            return;
+        }
+    case 'n':
+        switch (str[1]) {
+        case 'u':
+            switch (str[2]) {
+            case 'l':
+                switch (str[3]) {
+                case 'l':
+                    switch (str[4]) {
+                    case '\0':
+                        viable[0] |= 1;   /* NUL */
+                        return;
+                    default:
+                        return;
+                    }
+                case '\0':
+                    viable[0] |= 1;   /* NUL */
+                    viable[13] |= 16;   /* 'l' */
+                    return;
+                default:
+                    return;
+                }
+            case '\0':
+                viable[0] |= 1;   /* NUL */
+                viable[13] |= 16;   /* 'l' */
+                return;
+            default:
+                return;
+            }
+        case '\0':
+            viable[0] |= 1;   /* NUL */
+            viable[14] |= 32;   /* 'u' */
+            return;
+        default:
+            return;
+        }
+    case 't':
+        switch (str[1]) {
+        case 'r':
+            switch (str[2]) {
+            case 'u':
+                switch (str[3]) {
+                case 'e':
+                    switch (str[4]) {
+                    case '\0':
+                        viable[0] |= 1;   /* NUL */
+                        return;
+                    default:
+                        return;
+                    }
+                case '\0':
+                    viable[0] |= 1;   /* NUL */
+                    viable[12] |= 32;   /* 'e' */
+                    return;
+                default:
+                    return;
+                }
+            case '\0':
+                viable[0] |= 1;   /* NUL */
+                viable[14] |= 32;   /* 'u' */
+                return;
+            default:
+                return;
+            }
+        case '\0':
+            viable[0] |= 1;   /* NUL */
+            viable[14] |= 4;   /* 'r' */
+            return;
+        default:
+            return;
+        }
+    case '\0':
+        viable[0] |= 1;   /* NUL */
+        viable[12] |= 64;   /* 'f' */
+        viable[13] |= 64;   /* 'n' */
+        viable[14] |= 16;   /* 't' */
+        return;
+    default:
+        return;
+    }
+}
+
+#endif
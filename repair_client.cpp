@@ -0,0 +1,202 @@
+//-------------------------------------
+// repair_client.cpp
+//
+// Client of repaird (protocol in repaird.h).  Sends files for repair and
+// prints the results, or drives the daemon for a load test: the files are
+// sent -n times over in all, the -c connections taking the next request
+// from that shared pool, and the client reports the replies by kind,
+// throughput and latency as seen from the client.
+//
+// Build:  make repair_client
+// Usage:  ./repair_client [-s socket] [-d deadline_ms] [-c connections] [-n rounds]
+//                         [-o outdir] <format> <file> [file ...]
+//         ./repair_client [-s socket] --stats
+//-------------------------------------
+#include "repaird.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+
+typedef std::chrono::steady_clock Clock;
+
+int connectTo(const std::string& path) {
+    sockaddr_un addr;
+    if (!socketAddress(path, addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+struct Reply {
+    std::string kind;                 // OK, NONE, TIMEOUT, BUSY, ERROR, or "" if the connection failed
+    std::string body;
+    long long oracle_runs = 0;
+    long long server_micros = 0;
+};
+
+Reply request(Connection& conn, const std::string& format, long long deadline_ms, const std::string& input) {
+    Reply reply;
+    std::string header = "REPAIR " + format + " " + std::to_string(deadline_ms) + " "
+                         + std::to_string(input.size()) + "\n";
+    std::string line;
+    if (!conn.writeAll(header + input) || !conn.readLine(line)) return reply;
+    std::istringstream in(line);
+    long long length = 0;
+    in >> reply.kind;
+    if (reply.kind == "ERROR") {
+        reply.body = line.size() > 6 ? line.substr(6) : "";
+        return reply;
+    }
+    in >> length >> reply.oracle_runs >> reply.server_micros;
+    if (length > 0 && !conn.readExact(reply.body, static_cast<size_t>(length))) reply.kind.clear();
+    return reply;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options] <format> <file> [file ...]\n"
+              << "       " << prog << " [-s socket] --stats\n"
+              << "  -s, --socket <path>         daemon socket (default " REPAIRD_SOCKET ")\n"
+              << "  -d, --deadline <ms>         per-request deadline (default: the daemon's)\n"
+              << "  -c, --connections <n>       concurrent connections (load test)\n"
+              << "  -n, --rounds <n>            send every file n times in all, shared\n"
+              << "                              between the connections (load test)\n"
+              << "  -o, --output <dir>          write repaired files to <dir>\n"
+              << "      --stats                 print the daemon's counters\n";
+}
+
+int main(int argc, char* argv[]) {
+    static const struct option long_options[] = {
+        {"socket",      required_argument, nullptr, 's'},
+        {"deadline",    required_argument, nullptr, 'd'},
+        {"connections", required_argument, nullptr, 'c'},
+        {"rounds",      required_argument, nullptr, 'n'},
+        {"output",      required_argument, nullptr, 'o'},
+        {"stats",       no_argument,       nullptr, 'S'},
+        {nullptr, 0, nullptr, 0}
+    };
+    std::string socket_path = REPAIRD_SOCKET, outdir;
+    long long deadline_ms = 0;
+    int connections = 1, rounds = 1;
+    bool stats = false;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:d:c:n:o:", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 's': socket_path = optarg; break;
+        case 'd': deadline_ms = atoll(optarg); break;
+        case 'c': connections = std::max(1, atoi(optarg)); break;
+        case 'n': rounds = std::max(1, atoi(optarg)); break;
+        case 'o': outdir = optarg; break;
+        case 'S': stats = true; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (stats) {
+        int fd = connectTo(socket_path);
+        if (fd < 0) { perror("connect"); return 1; }
+        Connection conn(fd);
+        std::string line, body;
+        long long length = 0;
+        if (!conn.writeAll("STATS\n") || !conn.readLine(line)
+            || sscanf(line.c_str(), "STATS %lld", &length) != 1 || !conn.readExact(body, static_cast<size_t>(length))) {
+            std::cerr << "Error: no reply from " << socket_path << std::endl;
+            return 1;
+        }
+        std::cout << body;
+        return 0;
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string format = argv[optind];
+    std::vector<std::string> names(argv + optind + 1, argv + argc), inputs;
+    for (const auto& name : names) {
+        std::ifstream in(name, std::ios::binary);
+        if (!in) {
+            std::cerr << "Error: Could not open file " << name << std::endl;
+            return 1;
+        }
+        inputs.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Requests are handed out in order: file i of round r is number r * files + i
+    size_t total = inputs.size() * static_cast<size_t>(rounds);
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+    std::map<std::string, long long> kinds;
+    std::vector<double> latencies;
+    long long oracle_runs = 0;
+    bool verbose = connections == 1 && rounds == 1;
+
+    auto client = [&]() {
+        int fd = connectTo(socket_path);
+        if (fd < 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            perror("connect");
+            return;
+        }
+        Connection conn(fd);
+        for (size_t k; (k = next.fetch_add(1)) < total; ) {
+            size_t i = k % inputs.size();
+            Clock::time_point t0 = Clock::now();
+            Reply reply = request(conn, format, deadline_ms, inputs[i]);
+            double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+            std::lock_guard<std::mutex> lock(mutex);
+            kinds[reply.kind.empty() ? "FAILED" : reply.kind]++;
+            latencies.push_back(seconds);
+            oracle_runs += reply.oracle_runs;
+            if (verbose) {
+                printf("%s: %s oracle runs: %lld time: %.3fs%s%s\n", names[i].c_str(),
+                       reply.kind.empty() ? "FAILED" : reply.kind.c_str(), reply.oracle_runs, seconds,
+                       reply.kind == "ERROR" ? " " : "", reply.kind == "ERROR" ? reply.body.c_str() : "");
+            }
+            if (reply.kind == "OK" && !outdir.empty()) {
+                std::string base = names[i].substr(names[i].rfind('/') + 1);
+                std::ofstream out(outdir + "/" + base, std::ios::binary);
+                out << reply.body;
+            }
+            if (reply.kind.empty()) return;
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 1; c < connections; c++) threads.emplace_back(client);
+    client();
+    for (auto& t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto quantile = [&](double q) {
+        return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, static_cast<size_t>(q * latencies.size()))];
+    };
+    printf("*** Requests: %zu", latencies.size());
+    for (const auto& k : kinds) printf(" %s: %lld", k.first.c_str(), k.second);
+    printf(" ***\n");
+    printf("*** Throughput: %.1f requests/s over %.2fs, oracle runs: %lld ***\n",
+           elapsed > 0 ? latencies.size() / elapsed : 0.0, elapsed, oracle_runs);
+    printf("*** Latency ms: p50 %.1f p90 %.1f p99 %.1f max %.1f ***\n",
+           quantile(0.5) * 1000, quantile(0.9) * 1000, quantile(0.99) * 1000,
+           latencies.empty() ? 0.0 : latencies.back() * 1000);
+    return kinds.count("FAILED") || kinds.count("ERROR") ? 1 : 0;
+}
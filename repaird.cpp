@@ -0,0 +1,445 @@
+//-------------------------------------
+// repaird.cpp
+//
+// Resident repair service: accepts repair requests on a Unix socket (see
+// repaird.h for the protocol) and runs them on a fixed pool of workers.
+// Every worker keeps one librepair repairer per configured format, so the
+// oracle backends (and speculative workers, if enabled) stay warm between
+// requests.
+//
+// Admission control: a request is refused with BUSY when the queue is full,
+// or when its deadline is shorter than the expected wait for a worker
+// (queued requests x mean service time / workers).  A deadline that passes
+// while the request is queued or running ends it with TIMEOUT; queued
+// requests are expired by a timer thread, so they are answered on time even
+// when every worker is busy.  Inputs longer than --max-input are refused with
+// ERROR before their body is read.
+//
+// Build:  make repaird
+// Usage:  ./repaird [options] <format>=<parser_path> [<format>=<parser_path> ...]
+//-------------------------------------
+#include "librepair.h"
+#include "repaird.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+
+typedef std::chrono::steady_clock Clock;
+
+//-------------------------------------
+// 1. Counters
+//-------------------------------------
+class Counters {
+public:
+    // Latency buckets: [0, 1ms), [1, 2ms), [2, 4ms), ... ; the last one is open
+    static const int BUCKETS = 24;
+
+    std::atomic<long long> received{0}, busy{0}, completed{0}, repaired{0}, unrepaired{0};
+    std::atomic<long long> timeouts{0}, errors{0}, oracle_runs{0};
+    std::atomic<long long> service_micros{0};          // time spent in repair_run
+
+    void latency(double seconds) {
+        double ms = seconds * 1000;
+        int b = 0;
+        while (b < BUCKETS - 1 && ms >= (1 << b)) b++;
+        std::lock_guard<std::mutex> lock(mutex);
+        histogram[b]++;
+        total_seconds += seconds;
+        max_seconds = std::max(max_seconds, seconds);
+        samples++;
+    }
+
+    // Upper bound of the bucket holding quantile q, in ms
+    double quantileMs(double q) const {
+        long long rank = static_cast<long long>(q * samples), seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += histogram[b];
+            if (seen > rank) return b == 0 ? 1 : (1 << b);
+        }
+        return 0;
+    }
+
+    std::string report(size_t queued, int in_flight, int workers) {
+        std::lock_guard<std::mutex> lock(mutex);
+        double uptime = std::chrono::duration<double>(Clock::now() - start).count();
+        std::ostringstream out;
+        out << "uptime_seconds " << uptime << "\n"
+            << "workers " << workers << "\n"
+            << "queued " << queued << "\n"
+            << "in_flight " << in_flight << "\n"
+            << "received " << received << "\n"
+            << "busy " << busy << "\n"
+            << "completed " << completed << "\n"
+            << "repaired " << repaired << "\n"
+            << "unrepaired " << unrepaired << "\n"
+            << "timeouts " << timeouts << "\n"
+            << "errors " << errors << "\n"
+            << "oracle_runs " << oracle_runs << "\n"
+            << "throughput_per_second " << (uptime > 0 ? completed / uptime : 0) << "\n"
+            << "latency_mean_ms " << (samples ? total_seconds * 1000 / samples : 0) << "\n"
+            << "latency_p50_ms " << quantileMs(0.50) << "\n"
+            << "latency_p90_ms " << quantileMs(0.90) << "\n"
+            << "latency_p99_ms " << quantileMs(0.99) << "\n"
+            << "latency_max_ms " << max_seconds * 1000 << "\n";
+        return out.str();
+    }
+
+private:
+    std::mutex mutex;
+    long long histogram[BUCKETS] = {0};
+    long long samples = 0;
+    double total_seconds = 0, max_seconds = 0;
+    Clock::time_point start = Clock::now();
+};
+
+//-------------------------------------
+// 2. Request queue and workers
+//-------------------------------------
+struct Job {
+    std::string format;
+    std::string input;
+    Clock::time_point arrival;
+    Clock::time_point deadline;
+    std::promise<std::string> reply;      // header line (and body)
+};
+
+class Service {
+public:
+    Service(const std::map<std::string, std::string>& backends, const repair_config& base,
+            int workers, size_t max_queue, double default_deadline)
+        : max_queue(max_queue), default_deadline(default_deadline), worker_count(workers) {
+        for (int i = 0; i < workers; i++) {
+            std::map<std::string, repairer*> own;
+            for (const auto& b : backends) {
+                repair_config config = base;
+                config.parser_path = b.second.c_str();
+                repairer* r = repair_create(&config);
+                if (!r) throw std::runtime_error("cannot create a repairer for " + b.first + ": " + repair_create_error());
+                own[b.first] = r;
+            }
+            repairers.push_back(own);
+        }
+        for (int i = 0; i < workers; i++) threads.emplace_back([this, i] { work(i); });
+        threads.emplace_back([this] { expire(); });
+    }
+
+    ~Service() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        queued.notify_all();
+        for (auto& t : threads) t.join();
+        for (auto& own : repairers)
+            for (auto& r : own) repair_destroy(r.second);
+    }
+
+    bool knows(const std::string& format) const { return repairers[0].count(format) > 0; }
+
+    // Admit a job or refuse it (false: reply BUSY)
+    bool submit(std::unique_ptr<Job> job, double deadline_seconds) {
+        counters.received++;
+        if (deadline_seconds <= 0) deadline_seconds = default_deadline;
+        std::lock_guard<std::mutex> lock(mutex);
+        double mean = counters.completed ? counters.service_micros / 1e6 / counters.completed : 0;
+        double wait = (queue.size() + in_flight) * mean / worker_count;
+        if (queue.size() >= max_queue || (deadline_seconds > 0 && wait > deadline_seconds)) {
+            counters.busy++;
+            return false;
+        }
+        job->deadline = deadline_seconds > 0
+            ? job->arrival + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(deadline_seconds))
+            : Clock::time_point::max();
+        queue.push_back(std::move(job));
+        ready.notify_one();
+        queued.notify_one();
+        return true;
+    }
+
+    std::string stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counters.report(queue.size(), in_flight, worker_count);
+    }
+
+    Counters counters;
+
+private:
+    size_t max_queue;
+    double default_deadline;
+    int worker_count;
+    std::vector<std::map<std::string, repairer*>> repairers;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable queued;        // wakes the expiry timer
+    std::deque<std::unique_ptr<Job>> queue;
+    int in_flight = 0;
+    bool stopping = false;
+
+    static long long micros(Clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    }
+
+    // Answer for a job whose deadline passed before it got to a worker
+    std::string expired(const Job& job, Clock::time_point now) {
+        counters.timeouts++;
+        counters.latency(std::chrono::duration<double>(now - job.arrival).count());
+        return "TIMEOUT 0 0 " + std::to_string(micros(now - job.arrival)) + "\n";
+    }
+
+    // Timer: sleeps until the earliest queued deadline and answers the
+    // queued jobs that missed theirs
+    void expire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            Clock::time_point now = Clock::now(), next = Clock::time_point::max();
+            for (auto it = queue.begin(); it != queue.end();) {
+                if ((*it)->deadline <= now) {
+                    (*it)->reply.set_value(expired(**it, now));
+                    it = queue.erase(it);
+                } else {
+                    next = std::min(next, (*it)->deadline);
+                    ++it;
+                }
+            }
+            if (next == Clock::time_point::max()) queued.wait(lock);
+            else queued.wait_until(lock, next);
+        }
+    }
+
+    void work(int id) {
+        for (;;) {
+            std::unique_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+                in_flight++;
+            }
+            job->reply.set_value(run(id, *job));
+            std::lock_guard<std::mutex> lock(mutex);
+            in_flight--;
+        }
+    }
+
+    std::string run(int id, Job& job) {
+        Clock::time_point begin = Clock::now();
+        if (begin >= job.deadline) return expired(job, begin);
+        repairer* r = repairers[id][job.format];
+        repair_set_timeout(r, job.deadline == Clock::time_point::max()
+                                  ? 0 : std::chrono::duration<double>(job.deadline - begin).count());
+        char* output = nullptr;
+        size_t output_len = 0;
+        repair_stats stats;
+        repair_stats_init(&stats);
+        int rc = repair_run(r, job.input.data(), job.input.size(), &output, &output_len, &stats);
+        Clock::time_point end = Clock::now();
+        counters.service_micros += micros(end - begin);
+        counters.completed++;
+        counters.latency(std::chrono::duration<double>(end - job.arrival).count());
+        std::string elapsed = std::to_string(micros(end - job.arrival));
+
+        std::string reply;
+        if (rc == 0) {
+            counters.repaired++;
+            counters.oracle_runs += stats.oracle_runs;
+            reply = "OK " + std::to_string(output_len) + " " + std::to_string(stats.oracle_runs) + " " + elapsed + "\n";
+            reply.append(output, output_len);
+        } else if (rc == 1) {
+            counters.unrepaired++;
+            counters.oracle_runs += stats.oracle_runs;
+            reply = "NONE 0 " + std::to_string(stats.oracle_runs) + " " + elapsed + "\n";
+        } else if (rc == 2) {
+            counters.timeouts++;
+            counters.oracle_runs += stats.oracle_runs;
+            reply = "TIMEOUT 0 " + std::to_string(stats.oracle_runs) + " " + elapsed + "\n";
+        } else {
+            counters.errors++;
+            reply = std::string("ERROR ") + repair_last_error(r) + "\n";
+        }
+        repair_free(output);
+        return reply;
+    }
+};
+
+//-------------------------------------
+// 3. Connections
+//-------------------------------------
+void serve(Service& service, int fd, size_t max_input) {
+    Connection conn(fd);
+    std::string line, body;
+    while (conn.readLine(line)) {
+        std::istringstream header(line);
+        std::string command;
+        header >> command;
+        if (command == "STATS") {
+            std::string report = service.stats();
+            if (!conn.writeAll("STATS " + std::to_string(report.size()) + "\n" + report)) return;
+            continue;
+        }
+        std::string format;
+        long long deadline_ms = -1, length = -1;
+        header >> format >> deadline_ms >> length;
+        if (command != "REPAIR" || !header || deadline_ms < 0 || length < 0) {
+            conn.writeAll("ERROR bad request\n");
+            return;
+        }
+        if (static_cast<unsigned long long>(length) > max_input) {
+            // The body is not read, so the connection cannot go on
+            conn.writeAll("ERROR input too large\n");
+            return;
+        }
+        if (!conn.readExact(body, static_cast<size_t>(length))) return;
+        if (!service.knows(format)) {
+            if (!conn.writeAll("ERROR unknown format " + format + "\n")) return;
+            continue;
+        }
+        std::unique_ptr<Job> job(new Job);
+        job->format = format;
+        job->input.swap(body);
+        job->arrival = Clock::now();
+        std::future<std::string> reply = job->reply.get_future();
+        if (!service.submit(std::move(job), deadline_ms / 1000.0)) {
+            if (!conn.writeAll("BUSY 0 0 0\n")) return;
+            continue;
+        }
+        if (!conn.writeAll(reply.get())) return;
+    }
+}
+
+//-------------------------------------
+// 4. Main function
+//-------------------------------------
+static std::string socket_path = REPAIRD_SOCKET;
+
+static void stop(int) {
+    unlink(socket_path.c_str());
+    _exit(0);
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options] <format>=<parser_path> [...]\n"
+              << "  -s, --socket <path>         listen here (default " REPAIRD_SOCKET ")\n"
+              << "  -w, --workers <n>           concurrent repairs (default: number of CPUs)\n"
+              << "  -Q, --queue <n>             queued requests before refusing with BUSY (default 64)\n"
+              << "  -d, --deadline <ms>         deadline of requests that give none (default: none)\n"
+              << "      --max-input <bytes>     longest input accepted (default 64 MiB)\n"
+              << "      --speculate <k>         per-repairer speculation window (see erepair)\n"
+              << "  -j, --jobs <n>              speculative workers per repairer\n"
+              << "      --no-index              ask the parser every question (see erepair)\n"
+              << "      --persistent <n>        keep the subjects running in their --persistent mode\n"
+              << "      --portfolio             race repair strategies per request (see erepair)\n";
+}
+
+int main(int argc, char* argv[]) {
+    static const struct option long_options[] = {
+        {"socket",    required_argument, nullptr, 's'},
+        {"workers",   required_argument, nullptr, 'w'},
+        {"queue",     required_argument, nullptr, 'Q'},
+        {"deadline",  required_argument, nullptr, 'd'},
+        {"max-input", required_argument, nullptr, 'M'},
+        {"speculate", required_argument, nullptr, 'K'},
+        {"jobs",      required_argument, nullptr, 'j'},
+        {"no-index",  no_argument,       nullptr, 'N'},
+        {"persistent", required_argument, nullptr, 'I'},
+        {"portfolio", no_argument,       nullptr, 'F'},
+        {nullptr, 0, nullptr, 0}
+    };
+    repair_config base;
+    repair_config_init(&base);
+    int workers = static_cast<int>(std::thread::hardware_concurrency());
+    size_t max_queue = 64;
+    double default_deadline = 0;
+    size_t max_input = 64 << 20;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:w:Q:d:j:", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 's': socket_path = optarg; break;
+        case 'w': workers = atoi(optarg); break;
+        case 'Q': max_queue = static_cast<size_t>(atol(optarg)); break;
+        case 'd': default_deadline = atof(optarg) / 1000; break;
+        case 'M': max_input = static_cast<size_t>(atoll(optarg)); break;
+        case 'K': base.speculate = atoi(optarg); break;
+        case 'j': base.jobs = atoi(optarg); break;
+        case 'N': base.use_index = 0; break;
+        case 'I': base.persistent = atoi(optarg); break;
+        case 'F': base.portfolio = 1; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    std::map<std::string, std::string> backends;
+    for (int i = optind; i < argc; i++) {
+        const char* eq = strchr(argv[i], '=');
+        if (!eq || eq == argv[i] || !eq[1]) {
+            usage(argv[0]);
+            return 1;
+        }
+        backends[std::string(argv[i], eq - argv[i])] = eq + 1;
+    }
+    if (backends.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (workers < 1) workers = 1;
+    repair_set_logging(REPAIR_LOG_QUIET, 0, nullptr);
+
+    sockaddr_un addr;
+    if (!socketAddress(socket_path, addr)) {
+        std::cerr << "Error: socket path too long: " << socket_path << std::endl;
+        return 1;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(listener, 128) != 0) {
+        perror("listen");
+        return 1;
+    }
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::unique_ptr<Service> service;
+    try {
+        service.reset(new Service(backends, base, workers, max_queue, default_deadline));
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        unlink(socket_path.c_str());
+        return 1;
+    }
+    std::cerr << "[repaird] listening on " << socket_path << " with " << workers << " workers, "
+              << backends.size() << " formats" << std::endl;
+
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            perror("accept");
+            break;
+        }
+        std::thread(serve, std::ref(*service), fd, max_input).detach();
+    }
+    unlink(socket_path.c_str());
+    return 1;
+}
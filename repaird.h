@@ -0,0 +1,96 @@
+//-------------------------------------
+// repaird.h
+//
+// Wire protocol of repaird, shared by the daemon and repair_client.  One
+// request at a time per connection; headers are text lines, bodies raw bytes.
+//
+//   REPAIR <format> <deadline_ms> <length>\n<body>   deadline 0 = daemon default
+//   STATS\n
+//
+//   OK <length> <oracle_runs> <micros>\n<body>       repaired text
+//   NONE 0 <oracle_runs> <micros>\n                  no repair found
+//   TIMEOUT 0 <oracle_runs> <micros>\n               deadline passed (queued or running)
+//   BUSY 0 0 0\n                                     refused: queue full or deadline unreachable
+//   ERROR <message>\n
+//   STATS <length>\n<body>                           "name value" lines
+//-------------------------------------
+#pragma once
+
+#include <cerrno>
+#include <string>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define REPAIRD_SOCKET "/tmp/repaird.sock"
+
+// Buffered reader over a socket
+class Connection {
+public:
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { if (fd >= 0) close(fd); }
+
+    // Reads up to '\n' (not included); false at EOF or error
+    bool readLine(std::string& line) {
+        line.clear();
+        for (;;) {
+            size_t nl = buffer.find('\n', pos);
+            if (nl != std::string::npos) {
+                line.assign(buffer, pos, nl - pos);
+                pos = nl + 1;
+                return true;
+            }
+            if (buffer.size() - pos > (1u << 16)) return false;   // no header is that long
+            if (!fill()) return false;
+        }
+    }
+
+    bool readExact(std::string& out, size_t n) {
+        out.clear();
+        while (buffer.size() - pos < n) {
+            if (!fill()) return false;
+        }
+        out.assign(buffer, pos, n);
+        pos += n;
+        return true;
+    }
+
+    bool writeAll(const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    std::string buffer;
+    size_t pos = 0;
+
+    bool fill() {
+        if (pos > 0 && pos == buffer.size()) {
+            buffer.clear();
+            pos = 0;
+        }
+        char chunk[65536];
+        ssize_t n;
+        do {
+            n = recv(fd, chunk, sizeof chunk, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+};
+
+inline bool socketAddress(const std::string& path, sockaddr_un& addr) {
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    addr = sockaddr_un();
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, path.size());
+    return true;
+}
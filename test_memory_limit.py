@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Differential test: erepair with a tiny frontier memory limit vs. no limit.
+
+With -m the bucket queue spills the high-distance buckets to disk and reads
+them back when the search gets there; the search itself must not change.
+For every input and both bucket orders (FIFO and boundary) both runs must
+return the same repair and the same number of oracle runs.  The limit (about
+100 bytes) makes almost every push spill.
+
+Inputs: broken JSON documents from mutated_files/{single,double}_json.db.
+
+Usage:
+    python3 test_memory_limit.py [--erepair ./erepair] [--parser <cjson>] [--limit N]
+"""
+import argparse
+import os
+import re
+import sqlite3
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TINY = "0.0001"   # MiB
+ORDERS = ("fifo", "boundary")
+
+
+def repair(erepair, parser, data, extra):
+    with tempfile.TemporaryDirectory() as tmp:
+        src = os.path.join(tmp, "in.json")
+        dst = os.path.join(tmp, "out.json")
+        with open(src, "wb") as f:
+            f.write(data)
+        proc = subprocess.run([erepair, "-q"] + extra + [parser, src, dst],
+                              stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, timeout=300)
+        m = re.search(rb"Number of required oracle runs: (\d+)", proc.stdout)
+        runs = int(m.group(1)) if m else None
+        repaired = open(dst, "rb").read() if os.path.exists(dst) else None
+        return repaired, runs
+
+
+def inputs(limit):
+    result = []
+    for name in ("single_json.db", "double_json.db"):
+        db = os.path.join(HERE, "mutated_files", name)
+        if not os.path.exists(db):
+            continue
+        conn = sqlite3.connect(db)
+        rows = conn.execute("SELECT mutated_text FROM mutations WHERE mutated_text IS NOT NULL "
+                            "ORDER BY length(mutated_text) LIMIT ?", (limit,)).fetchall()
+        conn.close()
+        result += [text.encode("utf-8", "surrogateescape") for (text,) in rows]
+    return result
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--erepair", default=os.path.join(HERE, "erepair"))
+    ap.add_argument("--parser", default=os.path.join(HERE, "project", "erepair-subjects", "cjson", "cjson"))
+    ap.add_argument("--limit", type=int, default=15, help="inputs per DB")
+    args = ap.parse_args()
+
+    for path in (args.erepair, args.parser):
+        if not os.path.exists(path):
+            print(f"[ERROR] not found: {path}")
+            return 2
+
+    total = 0
+    mismatches = 0
+    for data in inputs(args.limit):
+        for order in ORDERS:
+            total += 1
+            extra = ["--bucket-order", order]
+            want = repair(args.erepair, args.parser, data, extra)
+            got = repair(args.erepair, args.parser, data, extra + ["-m", TINY])
+            if want != got or want[1] is None:
+                mismatches += 1
+                print(f"[MISMATCH] order={order} unlimited={want} limited={got} input={data[:200]!r}")
+    print(f"{total} runs, {mismatches} mismatches")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
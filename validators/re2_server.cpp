@@ -1,4 +1,5 @@
 #include <re2/re2.h>
+#include "regex_region.h"
 #include <algorithm>
 #include <cctype>
 #include <cstdio>
@@ -48,16 +49,7 @@ int main(int argc, char** argv) {
     }
     const std::string category = argv[1];
 
-    const auto pattern = [&]() -> const char* {
-        if (category == "Date") return R"(^\d{4}-\d{2}-\d{2}$)";
-        if (category == "Time") return R"(^\d{2}:\d{2}:\d{2}$)";
-        if (category == "URL")  return R"(^https?:\/\/(www\.)?[-a-zA-Z0-9@:%._\+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b([-a-zA-Z0-9()@:%_\+.~#?&//=]*)$)";
-        if (category == "ISBN") return R"(^(?:\d[- ]?){9}[\dX]$)";
-        if (category == "IPv4") return R"(^(\d{1,3}\.){3}\d{1,3}$)";
-        if (category == "IPv6") return R"(^([0-9a-fA-F]{1,4}:){7}[0-9a-fA-F]{1,4}$)";
-        if (category == "FilePath") return R"(^[a-zA-Z]:\\(?:[^\\/:*?"<>|\r\n]+\\)*[^\\/:*?"<>|\r\n]*$)";
-        return nullptr;
-    }();
+    const char* pattern = regexPattern(category);
 
     if (!pattern) {
         std::cerr << "Unknown category: " << category << "\n";
@@ -69,11 +61,16 @@ int main(int argc, char** argv) {
         std::cerr << "Error: invalid RE2 pattern for category: " << category << "\n";
         return 1;
     }
+    RegexAutomaton automaton(pattern);
 
     // Protocol:
     // - "FILE <path>\n"  : read file at <path>, trim, FullMatch. Respond "OK\n" or "ERR\n".
     // - "DATA <n>\n<bytes><NL>" : read exactly n bytes as data, then consume one trailing newline,
     //                            trim, FullMatch. Respond "OK\n" or "ERR\n".
+    // - "REGION <n>\n<bytes><NL>" : read data as for DATA. Respond "REGION <prefix> <suffix>\n":
+    //                            data[0, prefix) can be completed to a match and
+    //                            data[suffix, n) can end one (after trimming, as
+    //                            above); a full match gives "REGION <n> 0".
     // - "QUIT\n"         : exit 0
     std::string line;
     std::ios::sync_with_stdio(false);
@@ -89,8 +86,9 @@ int main(int argc, char** argv) {
             bool okread = read_file_trim(path, data);
             bool match = okread && RE2::FullMatch(data, re);
             std::cout << (match ? "OK" : "ERR") << std::endl;
-        } else if (line.rfind("DATA ", 0) == 0) {
-            const char* p = line.c_str() + 5;
+        } else if (line.rfind("DATA ", 0) == 0 || line.rfind("REGION ", 0) == 0) {
+            bool region = line[0] == 'R';
+            const char* p = line.c_str() + (region ? 7 : 5);
             char* endp = nullptr;
             unsigned long long n = std::strtoull(p, &endp, 10);
             if (endp == p) {
@@ -107,6 +105,11 @@ int main(int argc, char** argv) {
             if (c == '\n') {
                 std::cin.get();
             }
+            if (region) {
+                RegexRegion r = automaton.region(data.data(), data.size());
+                std::cout << "REGION " << r.prefix << " " << r.suffix << std::endl;
+                continue;
+            }
             // Do NOT trim raw DATA by default; keep behavior consistent with other validators:
             // existing flow trims input before matching, so do the same here.
             std::string t = trim(data);
@@ -0,0 +1,474 @@
+//-------------------------------------
+// regex_region.h
+//
+// Error region of a string in one of the regex formats, in two linear
+// passes: a walk of the pattern's automaton from the start finds the
+// longest prefix that can still be completed to a match, a walk of the
+// reversed pattern's automaton from the end finds the longest suffix that
+// a match can still end with.  A repair has to edit at or before the end
+// of the first and at or after the start of the second.  The input is
+// trimmed first, as re2_server trims it before FullMatch.
+//
+// The automaton is a byte-level Thompson NFA for the part of RE2's syntax
+// the patterns use: literals, escapes, classes, groups, alternation,
+// ? * + {n,m}, ^ $ \b.  Classes are matched byte by byte, so a negated
+// class takes each byte of a multi-byte character on its own.  States
+// from which no match can be reached any more are dropped as the walk
+// goes, so the walk dies exactly where the prefix stops being viable.
+//
+// next() answers which bytes may follow a string from the same forward
+// walk, so the regex formats need no oracle run for a next-byte query.
+//
+// Used by re2_server (REGION) and in-process by librepair.
+//-------------------------------------
+#pragma once
+
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The patterns of the regex formats, by re2_server category; nullptr if unknown
+inline const char* regexPattern(const std::string& category) {
+    if (category == "Date") return R"(^\d{4}-\d{2}-\d{2}$)";
+    if (category == "Time") return R"(^\d{2}:\d{2}:\d{2}$)";
+    if (category == "URL")  return R"(^https?:\/\/(www\.)?[-a-zA-Z0-9@:%._\+~#=]{1,256}\.[a-zA-Z0-9()]{1,6}\b([-a-zA-Z0-9()@:%_\+.~#?&//=]*)$)";
+    if (category == "ISBN") return R"(^(?:\d[- ]?){9}[\dX]$)";
+    if (category == "IPv4") return R"(^(\d{1,3}\.){3}\d{1,3}$)";
+    if (category == "IPv6") return R"(^([0-9a-fA-F]{1,4}:){7}[0-9a-fA-F]{1,4}$)";
+    if (category == "FilePath") return R"(^[a-zA-Z]:\\(?:[^\\/:*?"<>|\r\n]+\\)*[^\\/:*?"<>|\r\n]*$)";
+    return nullptr;
+}
+
+struct RegexRegion {
+    size_t prefix;      // s[0, prefix) can be completed to a match
+    size_t suffix;      // s[suffix, len) can be preceded to a match
+};
+
+class RegexAutomaton {
+public:
+    // Throws std::invalid_argument for syntax outside the supported part
+    explicit RegexAutomaton(const std::string& pattern) {
+        Parser parser{pattern, 0};
+        std::unique_ptr<Node> tree = parser.alternation();
+        if (parser.pos != pattern.size()) throw std::invalid_argument("unbalanced ')' in " + pattern);
+        forward.build(*tree, false);
+        backward.build(*tree, true);
+    }
+
+    RegexRegion region(const char* data, size_t len) const {
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+        size_t lo = 0, hi = len;
+        while (lo < hi && std::isspace(s[lo])) lo++;
+        while (hi > lo && std::isspace(s[hi - 1])) hi--;
+
+        RegexRegion r = { len, 0 };
+        if (!forward.alive() || !backward.alive()) return { 0, len };
+        if (lo == hi) return r;
+        // A byte that kills the walk counts once trimming keeps it: a
+        // blank does when the next non-blank byte comes
+        size_t k = forward.walk(s, lo, hi - lo, false);
+        if (k < hi - lo) {
+            size_t i = lo + k;
+            while (std::isspace(s[i])) i++;
+            r.prefix = i;
+        }
+        k = backward.walk(s, hi - 1, hi - lo, true);
+        if (k < hi - lo) {
+            size_t i = hi - 1 - k;
+            while (std::isspace(s[i])) i--;
+            r.suffix = i + 1;
+        }
+        return r;
+    }
+
+    // Bytes b for which region(data + b) finds all of data + b viable.  A
+    // blank is once data is (trimming drops it at the end); any other byte
+    // goes on from the walk over data after its leading blanks.
+    std::bitset<256> next(const char* data, size_t len) const {
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+        size_t lo = 0, hi = len;
+        while (lo < len && std::isspace(s[lo])) lo++;
+        while (hi > lo && std::isspace(s[hi - 1])) hi--;
+
+        std::bitset<256> viable, blank;
+        if (!forward.alive() || !backward.alive()) return viable;
+        for (int b = 0; b < 256; b++) blank[b] = std::isspace(b) != 0;
+        forward.walk(s, lo, len - lo, false, &viable);
+        viable &= ~blank;
+        if (lo == hi || forward.walk(s, lo, hi - lo, false) == hi - lo) viable |= blank;
+        return viable;
+    }
+
+private:
+    // Parse tree
+    struct Node {
+        enum Kind { BYTES, CONCAT, ALTERNATION, REPEAT, BEGIN, END, WORD_BOUNDARY } kind;
+        std::bitset<256> bytes;
+        std::vector<std::unique_ptr<Node>> children;
+        int min = 0, max = -1;          // REPEAT, max -1 = unbounded
+
+        explicit Node(Kind kind) : kind(kind) {}
+    };
+
+    struct Parser {
+        const std::string& p;
+        size_t pos;
+
+        [[noreturn]] void fail(const char* what) const {
+            throw std::invalid_argument(std::string(what) + " at " + std::to_string(pos) + " in " + p);
+        }
+        bool more() const { return pos < p.size(); }
+
+        std::unique_ptr<Node> alternation() {
+            std::unique_ptr<Node> first = concatenation();
+            if (!more() || p[pos] != '|') return first;
+            std::unique_ptr<Node> node(new Node(Node::ALTERNATION));
+            node->children.push_back(std::move(first));
+            while (more() && p[pos] == '|') {
+                pos++;
+                node->children.push_back(concatenation());
+            }
+            return node;
+        }
+
+        std::unique_ptr<Node> concatenation() {
+            std::unique_ptr<Node> node(new Node(Node::CONCAT));
+            while (more() && p[pos] != '|' && p[pos] != ')') node->children.push_back(repetition());
+            return node;
+        }
+
+        std::unique_ptr<Node> repetition() {
+            std::unique_ptr<Node> node = atom();
+            while (more()) {
+                int min, max;
+                char c = p[pos];
+                if (c == '?') { min = 0; max = 1; pos++; }
+                else if (c == '*') { min = 0; max = -1; pos++; }
+                else if (c == '+') { min = 1; max = -1; pos++; }
+                else if (c == '{') {
+                    pos++;
+                    min = number();
+                    max = min;
+                    if (more() && p[pos] == ',') {
+                        pos++;
+                        max = more() && p[pos] == '}' ? -1 : number();
+                    }
+                    if (!more() || p[pos] != '}' || (max >= 0 && max < min)) fail("bad repetition");
+                    pos++;
+                } else {
+                    break;
+                }
+                std::unique_ptr<Node> repeat(new Node(Node::REPEAT));
+                repeat->min = min;
+                repeat->max = max;
+                repeat->children.push_back(std::move(node));
+                node = std::move(repeat);
+            }
+            return node;
+        }
+
+        int number() {
+            size_t start = pos;
+            int n = 0;
+            while (more() && std::isdigit(static_cast<unsigned char>(p[pos])) && n < 10000) n = n * 10 + (p[pos++] - '0');
+            if (pos == start || n >= 10000) fail("bad count");
+            return n;
+        }
+
+        std::unique_ptr<Node> atom() {
+            char c = p[pos++];
+            if (c == '(') {
+                if (p.compare(pos, 2, "?:") == 0) pos += 2;
+                else if (more() && p[pos] == '?') fail("unsupported group");
+                std::unique_ptr<Node> node = alternation();
+                if (!more() || p[pos] != ')') fail("missing ')'");
+                pos++;
+                return node;
+            }
+            if (c == '^') return std::unique_ptr<Node>(new Node(Node::BEGIN));
+            if (c == '$') return std::unique_ptr<Node>(new Node(Node::END));
+            std::unique_ptr<Node> node(new Node(Node::BYTES));
+            if (c == '[') {
+                klass(node->bytes);
+            } else if (c == '.') {
+                node->bytes.set();
+                node->bytes.reset('\n');
+            } else if (c == '\\') {
+                if (more() && p[pos] == 'b') {
+                    pos++;
+                    return std::unique_ptr<Node>(new Node(Node::WORD_BOUNDARY));
+                }
+                escape(node->bytes);
+            } else if (c == '?' || c == '*' || c == '+' || c == '{') {
+                fail("nothing to repeat");
+            } else {
+                node->bytes.set(static_cast<unsigned char>(c));
+            }
+            return node;
+        }
+
+        // After a backslash: \d, \w, \s, control escapes, or the character itself
+        void escape(std::bitset<256>& bytes) {
+            if (!more()) fail("trailing backslash");
+            char c = p[pos++];
+            switch (c) {
+            case 'd': for (int b = '0'; b <= '9'; b++) bytes.set(b); break;
+            case 'w': for (int b = 0; b < 256; b++) if (word(b)) bytes.set(b); break;
+            case 's': for (const char* w = " \t\n\r\f\v"; *w; w++) bytes.set(static_cast<unsigned char>(*w)); break;
+            case 'n': bytes.set('\n'); break;
+            case 'r': bytes.set('\r'); break;
+            case 't': bytes.set('\t'); break;
+            case 'f': bytes.set('\f'); break;
+            case 'v': bytes.set('\v'); break;
+            default:
+                if (std::isalnum(static_cast<unsigned char>(c))) fail("unsupported escape");
+                bytes.set(static_cast<unsigned char>(c));
+            }
+        }
+
+        // After '[': members up to ']', with ranges and a leading '^'
+        void klass(std::bitset<256>& bytes) {
+            bool negated = more() && p[pos] == '^';
+            if (negated) pos++;
+            bool first = true;
+            while (more() && (p[pos] != ']' || first)) {
+                first = false;
+                std::bitset<256> member;
+                int low = -1;
+                if (p[pos] == '\\') {
+                    pos++;
+                    escape(member);
+                    if (member.count() == 1) for (int b = 0; b < 256; b++) if (member[b]) low = b;
+                } else {
+                    low = static_cast<unsigned char>(p[pos++]);
+                    member.set(low);
+                }
+                if (low >= 0 && pos + 1 < p.size() && p[pos] == '-' && p[pos + 1] != ']') {
+                    pos++;
+                    std::bitset<256> end;
+                    int high;
+                    if (p[pos] == '\\') {
+                        pos++;
+                        escape(end);
+                        if (end.count() != 1) fail("bad range");
+                        for (high = 0; !end[high]; high++) {}
+                    } else {
+                        high = static_cast<unsigned char>(p[pos++]);
+                    }
+                    if (high < low) fail("bad range");
+                    for (int b = low; b <= high; b++) member.set(b);
+                }
+                bytes |= member;
+            }
+            if (!more()) fail("missing ']'");
+            pos++;
+            if (negated) bytes.flip();
+        }
+    };
+
+    static bool word(int b) { return std::isalnum(b) || b == '_'; }
+
+    // Context of a position on one side: the edge of the input, or a byte
+    enum Side { EDGE = 0, WORD = 1, OTHER = 2 };
+    static Side side(unsigned char b) { return word(b) ? WORD : OTHER; }
+
+    struct Automaton {
+        struct State {
+            enum Kind { BYTES, SPLIT, EPSILON, BEGIN, END, WORD_BOUNDARY, MATCH } kind;
+            std::bitset<256> bytes;
+            int out = -1, out2 = -1;
+        };
+        std::vector<State> states;
+        int start = -1;
+        std::vector<std::bitset<3>> live;       // per state, by the side before it
+        std::bitset<256> of_side[3];            // the bytes of each side
+
+        bool alive() const { return live[start][EDGE]; }
+
+        int add(State::Kind kind, int out, int out2 = -1) {
+            State s;
+            s.kind = kind;
+            s.out = out;
+            s.out2 = out2;
+            states.push_back(s);
+            return static_cast<int>(states.size()) - 1;
+        }
+
+        // Entry state of node followed by next; reversed compiles the
+        // mirror image (concatenations backwards, ^ and $ swapped)
+        int compile(const Node& node, int next, bool reversed) {
+            switch (node.kind) {
+            case Node::BYTES: {
+                int s = add(State::BYTES, next);
+                states[s].bytes = node.bytes;
+                return s;
+            }
+            case Node::CONCAT:
+                if (reversed) {
+                    for (const auto& child : node.children) next = compile(*child, next, reversed);
+                } else {
+                    for (size_t i = node.children.size(); i-- > 0;) next = compile(*node.children[i], next, reversed);
+                }
+                return next;
+            case Node::ALTERNATION: {
+                int entry = compile(*node.children.back(), next, reversed);
+                for (size_t i = node.children.size() - 1; i-- > 0;) {
+                    entry = add(State::SPLIT, compile(*node.children[i], next, reversed), entry);
+                }
+                return entry;
+            }
+            case Node::REPEAT: {
+                const Node& body = *node.children[0];
+                int entry = next;
+                if (node.max < 0) {
+                    int loop = add(State::SPLIT, -1, next);
+                    int inner = compile(body, loop, reversed);
+                    states[loop].out = inner;
+                    entry = loop;
+                } else {
+                    for (int i = node.min; i < node.max; i++) {
+                        int inner = compile(body, entry, reversed);
+                        entry = add(State::SPLIT, inner, next);
+                    }
+                }
+                for (int i = 0; i < node.min; i++) entry = compile(body, entry, reversed);
+                return entry;
+            }
+            case Node::BEGIN:
+                return add(reversed ? State::END : State::BEGIN, next);
+            case Node::END:
+                return add(reversed ? State::BEGIN : State::END, next);
+            case Node::WORD_BOUNDARY:
+                return add(State::WORD_BOUNDARY, next);
+            }
+            return next;
+        }
+
+        void build(const Node& tree, bool reversed) {
+            int match = add(State::MATCH, -1);
+            start = compile(tree, match, reversed);
+            computeLiveness();
+        }
+
+        // States reachable from `from` without consuming, between a byte
+        // (or edge) of side `before` and one of side `after`
+        void closure(int from, Side before, Side after, std::vector<int>& out,
+                     std::vector<unsigned>& mark, unsigned stamp) const {
+            std::vector<int> stack(1, from);
+            while (!stack.empty()) {
+                int q = stack.back();
+                stack.pop_back();
+                if (q < 0 || mark[q] == stamp) continue;
+                mark[q] = stamp;
+                const State& s = states[q];
+                switch (s.kind) {
+                case State::BYTES:
+                case State::MATCH:
+                    out.push_back(q);
+                    break;
+                case State::SPLIT:
+                    stack.push_back(s.out2);
+                    stack.push_back(s.out);
+                    break;
+                case State::EPSILON:
+                    stack.push_back(s.out);
+                    break;
+                case State::BEGIN:
+                    if (before == EDGE) stack.push_back(s.out);
+                    break;
+                case State::END:
+                    if (after == EDGE) stack.push_back(s.out);
+                    break;
+                case State::WORD_BOUNDARY:
+                    if ((before == WORD) != (after == WORD)) stack.push_back(s.out);
+                    break;
+                }
+            }
+        }
+
+        // live[q][before]: a match can still be reached from q
+        void computeLiveness() {
+            for (int b = 0; b < 256; b++) of_side[side(static_cast<unsigned char>(b))].set(b);
+            size_t n = states.size();
+            // Reverse edges between (state, side before) nodes
+            std::vector<std::vector<int>> into(n * 3);
+            std::vector<int> queue;
+            std::vector<char> seen(n * 3, 0);
+            std::vector<unsigned> mark(n, 0);
+            unsigned stamp = 0;
+            std::vector<int> reached;
+            for (size_t q = 0; q < n; q++) {
+                for (int before = 0; before < 3; before++) {
+                    int node = static_cast<int>(q) * 3 + before;
+                    for (int after = 0; after < 3; after++) {
+                        reached.clear();
+                        closure(static_cast<int>(q), Side(before), Side(after), reached, mark, ++stamp);
+                        for (int t : reached) {
+                            const State& s = states[t];
+                            if (s.kind == State::MATCH) {
+                                if (after == EDGE && !seen[node]) { seen[node] = 1; queue.push_back(node); }
+                            } else if (after != EDGE && (s.bytes & of_side[after]).any()) {
+                                into[s.out * 3 + after].push_back(node);
+                            }
+                        }
+                    }
+                }
+            }
+            for (size_t i = 0; i < queue.size(); i++) {
+                for (int node : into[queue[i]]) {
+                    if (!seen[node]) { seen[node] = 1; queue.push_back(node); }
+                }
+            }
+            live.assign(n, std::bitset<3>());
+            for (size_t i = 0; i < n * 3; i++) if (seen[i]) live[i / 3].set(i % 3);
+        }
+
+        // Bytes of s[from], s[from + 1], ... (or s[from], s[from - 1], ...
+        // backwards; n of them) consumed before no live state is left.  If
+        // all n are, following gets the bytes that can come next.
+        size_t walk(const unsigned char* s, size_t from, size_t n, bool backwards,
+                    std::bitset<256>* following = nullptr) const {
+            std::vector<int> current(1, start), next, reached;
+            std::vector<unsigned> mark(states.size(), 0), added(states.size(), 0);
+            unsigned stamp = 0;
+            Side before = EDGE;
+            for (size_t k = 0; k < n; k++) {
+                unsigned char c = s[backwards ? from - k : from + k];
+                Side after = side(c);
+                reached.clear();
+                ++stamp;
+                for (int q : current) closure(q, before, after, reached, mark, stamp);
+                next.clear();
+                for (int t : reached) {
+                    const State& s = states[t];
+                    if (s.kind == State::BYTES && s.bytes[c] && live[s.out][after] && added[s.out] != stamp) {
+                        added[s.out] = stamp;
+                        next.push_back(s.out);
+                    }
+                }
+                if (next.empty()) return k;
+                current.swap(next);
+                before = after;
+            }
+            if (following) {
+                following->reset();
+                for (Side after : { WORD, OTHER }) {
+                    reached.clear();
+                    ++stamp;
+                    for (int q : current) closure(q, before, after, reached, mark, stamp);
+                    for (int t : reached) {
+                        const State& s = states[t];
+                        if (s.kind == State::BYTES && live[s.out][after]) *following |= s.bytes & of_side[after];
+                    }
+                }
+            }
+            return n;
+        }
+    };
+
+    Automaton forward, backward;
+};